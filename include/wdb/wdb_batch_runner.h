@@ -0,0 +1,65 @@
+#ifndef WDB_WDB_BATCH_RUNNER_H
+#define WDB_WDB_BATCH_RUNNER_H
+
+#include <wdb/wdb_wabt.h>
+
+namespace wdb {
+    /**
+     * Run exported functions of the loaded module on a pool of threads,
+     * every job runs in its own executor
+     */
+    class WdbBatchRunner {
+    public:
+        struct Job {
+            // Exported function of the main module, without parameters
+            std::string exportName;
+            // Bind host functions of the job executor
+            std::function<void(wdb::WdbExecutor*)> preSetup;
+        };
+
+        struct JobResult {
+            wabt::Result result = wabt::Result::Error;
+            wabt::interp::TypedValues values;
+            std::string output;
+            std::string error;
+        };
+
+        /**
+         * Create a batch runner
+         * @param wabt loaded module
+         */
+        WdbBatchRunner(WdbWabt* wabt);
+
+        /**
+         * Set the number of worker threads
+         * @param threads 0 for one per hardware thread
+         */
+        void SetThreadCount(unsigned threads) { m_threadCount = threads; }
+
+        /**
+         * Set the options of the job executors, the job preSetup runs after the options preSetup
+         * @param options
+         */
+        void SetExecutorOptions(WdbExecutor::Options options) { m_options = std::move(options); }
+
+        /**
+         * Run jobs and wait for them to complete
+         * @param jobs
+         * @return results in the order of the jobs
+         */
+        std::vector<JobResult> Run(const std::vector<Job>& jobs);
+    private:
+        WdbWabt* m_wabt;
+        unsigned m_threadCount = 0;
+        WdbExecutor::Options m_options;
+
+        /**
+         * Run one job in a new executor
+         * @param job
+         * @return job result
+         */
+        JobResult RunJob(const Job& job);
+    };
+}
+
+#endif
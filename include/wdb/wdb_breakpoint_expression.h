@@ -0,0 +1,97 @@
+#ifndef WDB_WDB_BREAKPOINT_EXPRESSION_H
+#define WDB_WDB_BREAKPOINT_EXPRESSION_H
+
+#include <wabt/src/interp/interp.h>
+#include <string>
+#include <vector>
+
+namespace wdb {
+    /**
+     * Integer expression over the paused state, compiled to a small bytecode evaluated at breakpoints
+     *
+     * Operands are 64 bit integers:
+     *  - decimal or 0x hexadecimal literals
+     *  - stack[-N] and stack64[-N] for the low 32 bits (sign extended) or all bits of the N-th value from the top
+     *  - global[N] for a global, floats are read as their bits
+     *  - i8, u8, i16, u16, i32, u32 and i64[address] for little endian loads from memory 0
+     * Operators follow C precedence: unary - ! ~, * / %, + -, << >>, < <= > >=, == !=, &, ^, |, &&, ||
+     * and && and || only evaluate their right operand when the left one does not decide the result
+     */
+    class WdbBreakpointExpression {
+    public:
+        /**
+         * Compile an expression
+         * @param text
+         * @param error description of the first error, optional
+         * @return result
+         */
+        wabt::Result Compile(const std::string& text, std::string* error);
+
+        /**
+         * Check if an expression was compiled
+         * @return true if empty
+         */
+        bool IsEmpty() const { return m_code.empty(); }
+
+        /**
+         * Evaluate the expression
+         * @param env
+         * @param thread
+         * @param value
+         * @return result, error when a stack slot, global or memory address is out of range or on division by zero
+         */
+        wabt::Result Evaluate(wabt::interp::Environment* env, const wabt::interp::Thread* thread,
+                              int64_t* value) const;
+    private:
+        enum OpCode {
+            OP_CONST,
+            OP_STACK32,
+            OP_STACK64,
+            OP_GLOBAL,
+            OP_LOAD_I8,
+            OP_LOAD_U8,
+            OP_LOAD_I16,
+            OP_LOAD_U16,
+            OP_LOAD_I32,
+            OP_LOAD_U32,
+            OP_LOAD_I64,
+            OP_NEG,
+            OP_NOT,
+            OP_BIT_NOT,
+            OP_BOOL,
+            OP_MUL,
+            OP_DIV,
+            OP_REM,
+            OP_ADD,
+            OP_SUB,
+            OP_SHL,
+            OP_SHR,
+            OP_LT,
+            OP_LE,
+            OP_GT,
+            OP_GE,
+            OP_EQ,
+            OP_NE,
+            OP_AND,
+            OP_XOR,
+            OP_OR,
+            // Jump to the operand with the value kept when it decides the result, pop it otherwise
+            OP_AND_THEN,
+            OP_OR_ELSE
+        };
+
+        struct Op {
+            OpCode code;
+            int64_t operand;
+        };
+
+        // Postfix code with forward jumps and the evaluation stack it needs
+        std::vector<Op> m_code;
+        size_t m_maxDepth = 0;
+        mutable std::vector<int64_t> m_values;
+
+        class Parser;
+    };
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef WDB_WDB_CALL_TREE_H
+#define WDB_WDB_CALL_TREE_H
+
+#include <wabt/src/common.h>
+#include <functional>
+#include <unordered_map>
+
+namespace wdb {
+    /**
+     * Tree of call stacks with a value accumulated per stack
+     */
+    class WdbCallTree {
+    public:
+        // Parent of the outermost frames
+        static const uint32_t kNoNode = UINT32_MAX;
+
+        /**
+         * Get the node of a function called from parent, creating it if needed
+         * @param parent
+         * @param function
+         * @return node
+         */
+        uint32_t GetChild(uint32_t parent, wabt::Index function);
+
+        /**
+         * Get the function of a node
+         * @param node
+         * @return function index
+         */
+        wabt::Index GetFunction(uint32_t node) const { return m_nodes[node].function; }
+
+        /**
+         * Get the parent of a node
+         * @param node
+         * @return parent node or kNoNode
+         */
+        uint32_t GetParent(uint32_t node) const { return m_nodes[node].parent; }
+
+        /**
+         * Add to the value of a node
+         * @param node
+         * @param value
+         */
+        void AddValue(uint32_t node, uint64_t value) { m_nodes[node].value += value; }
+
+        /**
+         * Get the value of a node
+         * @param node
+         * @return value
+         */
+        uint64_t GetValue(uint32_t node) const { return m_nodes[node].value; }
+
+        /**
+         * Get the number of nodes
+         * @return node count
+         */
+        uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+
+        /**
+         * Get the values in folded flame graph format
+         * @param getName
+         * @param scale applied to the values
+         * @return one "caller;callee value" line per stack
+         */
+        std::string GetFoldedStacks(std::function<std::string(wabt::Index)> getName, double scale = 1) const;
+    private:
+        struct Node {
+            uint32_t parent;
+            wabt::Index function;
+            uint64_t value;
+        };
+
+        std::vector<Node> m_nodes;
+        std::unordered_map<uint64_t, uint32_t> m_nodeIndex;
+    };
+}
+
+#endif
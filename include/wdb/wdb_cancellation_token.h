@@ -0,0 +1,32 @@
+#ifndef WDB_WDB_CANCELLATION_TOKEN_H
+#define WDB_WDB_CANCELLATION_TOKEN_H
+
+#include <atomic>
+
+namespace wdb {
+    /**
+     * Flag shared with executors to stop them from any thread
+     */
+    class WdbCancellationToken {
+    public:
+        /**
+         * Request executors using this token to stop
+         */
+        void Cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+        /**
+         * Clear a cancellation request
+         */
+        void Reset() { m_cancelled.store(false, std::memory_order_relaxed); }
+
+        /**
+         * Check if cancellation was requested
+         * @return true if cancelled
+         */
+        bool IsCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<bool> m_cancelled{false};
+    };
+}
+
+#endif
@@ -16,6 +16,14 @@ namespace wdb {
          */
         wabt::Result SetupCode(std::vector<uint8_t> *fileData);
 
+        /**
+         * Set up environment from module bytes that are not copied
+         * @param data
+         * @param size
+         * @return result
+         */
+        wabt::Result SetupCode(const uint8_t* data, size_t size);
+
         /**
          * Get wat code
          * @param watOptions
@@ -2,14 +2,40 @@
 #define WDB_WDB_DEBUGGER_EXECUTOR_H
 
 #include <wdb/wdb_executor.h>
+#include <wdb/wdb_stop_map.h>
+#include <wdb/wdb_disassembly_index.h>
+#include <wdb/wdb_breakpoint_expression.h>
 #include <set>
+#include <map>
 
 namespace wdb {
     class WdbDebuggerExecutor : public WdbExecutor {
     public:
-        struct Instruction {
-            wabt::interp::IstreamOffset istream_start;
-            std::string str;
+        typedef WdbDisassemblyIndex::Instruction Instruction;
+
+        // Optional behaviour of a breakpoint
+        struct BreakpointOptions {
+            // Expression that must be non zero for a hit, see WdbBreakpointExpression, empty always hits
+            std::string condition;
+            // Hits passed over before stopping
+            uint64_t ignoreCount = 0;
+            // Log this message on every hit instead of stopping, {expression} is replaced by its value
+            std::string logMessage;
+        };
+
+        // Accesses stopping at a watchpoint
+        enum WatchKind {
+            WATCH_READ = 1,
+            WATCH_WRITE = 2,
+            WATCH_ACCESS = WATCH_READ | WATCH_WRITE
+        };
+
+        // Watched byte range of a linear memory
+        struct Watchpoint {
+            wabt::Index memoryIndex;
+            uint64_t offset;
+            uint64_t size;
+            WatchKind kind;
         };
 
         /**
@@ -26,16 +52,86 @@ namespace wdb {
 
         /**
          * Continue executing instructions till hitting return or break point
-         * @return result
+         * @return result, error without running when watchpoints are set and the istream cannot be decoded
          */
         wabt::Result Execute();
 
+        /**
+         * Execute the next instruction, running a called function until it returns
+         * @return result
+         */
+        wabt::Result StepOver();
+
+        /**
+         * Run until the current function has returned to its caller or a breakpoint is hit
+         * @return result
+         */
+        wabt::Result StepOut();
+
+        /**
+         * Run until the current function is about to return or a breakpoint is hit
+         * @return result
+         */
+        wabt::Result RunToReturn();
+
+        /**
+         * Keep a checkpoint of the current state so that execution can be reversed by re-executing
+         * from it, call after setting the main function and before executing it, further checkpoints
+         * are taken while executing so that going back re-executes from the nearest one, a checkpoint only
+         * keeps the memory pages that changed since the previous one and shares the others
+         * @param trackDirtyPages find the changed pages from their writes instead of comparing every page
+         * at each checkpoint and restore, stores then run one at a time, see TrackDirtyPages
+         * @return result
+         */
+        wabt::Result EnableReverseExecution(bool trackDirtyPages = false);
+
+        /**
+         * Go back to the state before the last executed instruction,
+         * after a trap this is the state before the trapping instruction
+         * @return result
+         */
+        wabt::Result StepBack();
+
+        /**
+         * Go back to the previous breakpoint hit that stops, or to the first checkpoint if there is none,
+         * tracepoints and ignored hits are passed over
+         * @return result
+         */
+        wabt::Result ReverseContinue();
+
         /**
          * Add breakpoint
          * @param offset
          */
         void AddBreakpoint(wabt::interp::IstreamOffset offset);
 
+        /**
+         * Add a conditional breakpoint, hit counting breakpoint or tracepoint,
+         * expressions are compiled once and only evaluated when the offset is reached
+         * @param offset
+         * @param options
+         * @param error description of an invalid expression, optional
+         * @return result
+         */
+        wabt::Result AddBreakpoint(wabt::interp::IstreamOffset offset, const BreakpointOptions& options,
+                                   std::string* error);
+
+        /**
+         * Get the number of times a breakpoint was hit, counting hits with a true condition only,
+         * going back in the execution takes back the later hits
+         * @param offset
+         * @return hits
+         */
+        uint64_t GetBreakpointHits(wabt::interp::IstreamOffset offset) const;
+
+        /**
+         * Set the handler receiving tracepoint messages, messages are posted as output otherwise
+         * @param handler
+         */
+        void SetTraceHandler(std::function<void(wabt::interp::IstreamOffset offset, std::string message)> handler) {
+            m_traceHandler = std::move(handler);
+        }
+
         /**
          * Remove breakpoint
          * @param offset
@@ -49,20 +145,239 @@ namespace wdb {
         std::set<wabt::interp::IstreamOffset> GetBreakpoints() const { return m_breakPc; }
 
         /**
-         * Get disassembled module
+         * Add a watchpoint stopping before an instruction reads or writes a byte range of a memory,
+         * load, store, atomic and bulk memory instructions are checked while watchpoints are set,
+         * a host function writing the range through the executor stops after its call
+         * @param memoryIndex environment index of the memory
+         * @param offset first watched byte
+         * @param size number of watched bytes
+         * @param kind accesses to stop at
+         * @return result, error when the istream cannot be decoded
+         */
+        wabt::Result AddWatchpoint(wabt::Index memoryIndex, uint64_t offset, uint64_t size, WatchKind kind);
+
+        /**
+         * Remove the watchpoints on a byte range
+         * @param memoryIndex
+         * @param offset
+         * @param size
+         */
+        void RemoveWatchpoint(wabt::Index memoryIndex, uint64_t offset, uint64_t size);
+
+        /**
+         * Get watchpoints
+         * @return vector of watchpoints
+         */
+        const std::vector<Watchpoint>& GetWatchpoints() const { return m_watchpoints; }
+
+        /**
+         * Get the watchpoint the last execution stopped at, the pc is on the accessing instruction
+         * @param watchpoint
+         * @param address first watched byte of the access
+         * @return true if the last execution stopped at a watchpoint
+         */
+        bool GetWatchpointHit(Watchpoint* watchpoint, uint64_t* address) const;
+
+        /**
+         * Get disassembled module, prefer formatting the lines shown from the disassembly index
          * @param module
-         *
-         * Note: This code is a modified version of the method Environment::Disassemble()
          */
         std::vector<Instruction> DisassembleModule(wabt::interp::DefinedModule* module);
 
+        /**
+         * Get the disassembly index of a module, kept until the module changes
+         * @param module
+         * @return index
+         */
+        WdbDisassemblyIndex* GetDisassemblyIndex(wabt::interp::DefinedModule* module);
+
         /**
          * Get relative pc offset
          * @return pc offset
          */
         wabt::interp::IstreamOffset GetPcOffset();
+    protected:
+        /**
+         * Check a memory write of a host function against the watchpoints
+         * @param memoryIndex
+         * @param offset
+         * @param size
+         */
+        void OnHostMemoryWrite(wabt::Index memoryIndex, uint64_t offset, uint64_t size);
     private:
+        // Compiled breakpoint options
+        struct Breakpoint {
+            WdbBreakpointExpression condition;
+            uint64_t ignoreCount = 0;
+            uint64_t hits = 0;
+            bool tracepoint = false;
+            // Message text around the logged expressions, one more than the expressions
+            std::vector<std::string> logText;
+            std::vector<WdbBreakpointExpression> logValues;
+        };
+
         std::set<wabt::interp::IstreamOffset> m_breakPc;
+        std::map<wabt::interp::IstreamOffset, Breakpoint> m_breakpoints;
+        std::function<void(wabt::interp::IstreamOffset, std::string)> m_traceHandler;
+        WdbStopMap m_breakMap;
+        bool m_breakMapDirty = true;
+        // Stops at calls, returns, breakpoints and watched accesses to follow the call depth
+        WdbStopMap m_stepMap;
+        bool m_stepMapDirty = true;
+        std::map<wabt::interp::DefinedModule*, WdbDisassemblyIndex> m_disassemblyIndexes;
+        // Watchpoints with one bit per watched page of each memory
+        std::vector<Watchpoint> m_watchpoints;
+        std::map<wabt::Index, std::vector<uint64_t>> m_watchPages;
+        bool m_watchHit = false;
+        Watchpoint m_watchHitPoint;
+        uint64_t m_watchHitAddress = 0;
+        // Checkpoint with the breakpoint hits counted before it, unchanged memory pages are shared
+        // between checkpoints and freed once no checkpoint keeps them
+        struct Checkpoint {
+            WdbSnapshot snapshot;
+            std::map<wabt::interp::IstreamOffset, uint64_t> hits;
+        };
+
+        // Reverse execution, checkpoints by instruction count starting where it was enabled
+        bool m_reversible = false;
+        std::vector<Checkpoint> m_checkpoints;
+        uint64_t m_checkpointInterval = 0;
+        // Set when the last run trapped or returned, the instruction count then stops at its batch
+        bool m_ended = false;
+
+        /**
+         * Make the breakpoint map reflect the current breakpoints
+         * @return true if the map can be used
+         */
+        bool PrepareBreakMap();
+
+        /**
+         * Check if the condition of a breakpoint holds, a condition that cannot be evaluated holds
+         * @param breakpoint
+         * @return true if hit
+         */
+        bool IsConditionMet(const Breakpoint& breakpoint);
+
+        /**
+         * Count a hit of the breakpoint at offset and log its tracepoint message
+         * @param offset
+         * @return true if the execution should stop
+         */
+        bool ShouldBreak(wabt::interp::IstreamOffset offset);
+
+        /**
+         * Rebuild the watched pages after the watchpoints changed
+         */
+        void UpdateWatchPages();
+
+        /**
+         * Check if an instruction may access a watched memory, these are stops of the maps
+         * @param instruction
+         * @return true if it needs checking
+         */
+        bool IsWatchedInstruction(const WdbInstructionDecoder::Instruction& instruction) const;
+
+        /**
+         * Check if the instruction at pc, about to be executed, accesses a watchpoint and record the hit
+         * @param instruction
+         * @return true if the execution should stop
+         */
+        bool IsWatchHit(const WdbInstructionDecoder::Instruction& instruction);
+
+        /**
+         * Check if an access to a byte range hits a watchpoint and record the hit
+         * @param memoryIndex
+         * @param address
+         * @param size
+         * @param reads
+         * @param writes
+         * @return true if hit
+         */
+        bool IsWatchedRange(wabt::Index memoryIndex, uint64_t address, uint64_t size, bool reads, bool writes);
+
+        /**
+         * Make the step map reflect the current breakpoints
+         * @return true if the map can be used
+         */
+        bool PrepareStepMap();
+
+        /**
+         * Run the current function until it returns
+         * @param beforeReturn stop before executing its return instead of after
+         * @return result
+         */
+        wabt::Result RunUntilReturn(bool beforeReturn);
+
+        /**
+         * Get how an executed instruction changed the call depth
+         * @param instruction
+         * @param hostCall the instruction called a host function, see IsHostCall
+         * @return 1 when a frame was entered, -1 when one was left, 0 otherwise
+         */
+        int GetDepthChange(const WdbInstructionDecoder::Instruction& instruction, bool hostCall) const;
+
+        /**
+         * Run instructions, taking a checkpoint after them when one is due
+         * @param count
+         * @return result
+         */
+        wabt::interp::Result RunAndCheckpoint(int count);
+
+        /**
+         * Take a checkpoint at the current position, thinning out the checkpoints when there are too many
+         */
+        void AddCheckpoint();
+
+        /**
+         * Save the current breakpoint hits in a checkpoint
+         * @param checkpoint
+         */
+        void AddCheckpointHits(Checkpoint* checkpoint);
+
+        /**
+         * Restore the last checkpoint before a position with its breakpoint hits,
+         * the checkpoints after the position are dropped
+         * @param position
+         * @return result
+         */
+        wabt::Result RestoreCheckpoint(uint64_t position);
+
+        /**
+         * Re-execute instructions counting the breakpoint hits before a position
+         * @param end instruction count to stop at
+         * @param lastStop set to the position of the last hit that stops, optional
+         * @return result
+         */
+        wabt::interp::Result Replay(uint64_t end, uint64_t* lastStop);
+
+        /**
+         * Count a hit of the breakpoint at offset without logging, as when re-executing
+         * @param offset
+         * @return true if the hit stops
+         */
+        bool CountHit(wabt::interp::IstreamOffset offset);
+
+        /**
+         * Record how the last run ended
+         * @param result
+         * @return result
+         */
+        wabt::interp::Result EndRun(wabt::interp::Result result);
+
+        /**
+         * Get the number of executed instructions, counting the instructions of a
+         * trapped or returned run up to its last instruction
+         * @param position
+         * @return result
+         */
+        wabt::Result GetPosition(uint64_t* position);
+
+        /**
+         * Restore the last checkpoint before a position and re-execute instructions
+         * @param position instruction count to stop at
+         * @return result
+         */
+        wabt::Result RunToPosition(uint64_t position);
     };
 }
 
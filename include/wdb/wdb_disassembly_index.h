@@ -0,0 +1,87 @@
+#ifndef WDB_WDB_DISASSEMBLY_INDEX_H
+#define WDB_WDB_DISASSEMBLY_INDEX_H
+
+#include <wdb/wdb_instruction_decoder.h>
+#include <wabt/src/interp/interp.h>
+#include <string>
+#include <vector>
+
+namespace wdb {
+    /**
+     * Instruction offsets of a module, decoded on demand, with text formatted only for the requested lines
+     */
+    class WdbDisassemblyIndex {
+    public:
+        struct Instruction {
+            wabt::interp::IstreamOffset istream_start;
+            std::string str;
+        };
+
+        /**
+         * Create an index over the istream range of a module
+         * @param env
+         * @param module
+         */
+        WdbDisassemblyIndex(wabt::interp::Environment* env, wabt::interp::DefinedModule* module);
+
+        /**
+         * Check if the index still matches the istream range of its module
+         * @return true if up to date
+         */
+        bool IsUpToDate() const;
+
+        /**
+         * Get the number of instructions of the module, decodes the whole range
+         * @return instructions count
+         */
+        size_t GetInstructionCount();
+
+        /**
+         * Get the offset of an instruction
+         * @param index
+         * @param offset
+         * @return result, error past the last instruction
+         */
+        wabt::Result GetOffset(size_t index, wabt::interp::IstreamOffset* offset);
+
+        /**
+         * Find the instruction containing an offset
+         * @param offset e.g. the pc
+         * @param index
+         * @return result, error outside of the module
+         */
+        wabt::Result FindInstruction(wabt::interp::IstreamOffset offset, size_t* index);
+
+        /**
+         * Decode an instruction without formatting it
+         * @param index
+         * @param instruction
+         * @return result, error past the last instruction
+         */
+        wabt::Result Decode(size_t index, WdbInstructionDecoder::Instruction* instruction);
+
+        /**
+         * Format a window of instructions
+         * @param first index of the first instruction
+         * @param count maximum number of instructions
+         * @return formatted instructions
+         */
+        std::vector<Instruction> Format(size_t first, size_t count);
+    private:
+        wabt::interp::Environment* m_env;
+        wabt::interp::DefinedModule* m_module;
+        wabt::interp::IstreamOffset m_start;
+        wabt::interp::IstreamOffset m_end;
+        // Offsets decoded so far, in istream order
+        std::vector<wabt::interp::IstreamOffset> m_offsets;
+        wabt::interp::IstreamOffset m_decoded;
+
+        /**
+         * Decode the next instruction offset
+         * @return false at the end of the module or if the istream cannot be decoded
+         */
+        bool DecodeNext();
+    };
+}
+
+#endif
@@ -1,12 +1,21 @@
 #ifndef WDB_WDB_EXECUTOR_H
 #define WDB_WDB_EXECUTOR_H
 
+#include <wdb/wdb_memory_search.h>
+#include <wdb/wdb_snapshot.h>
+#include <wdb/wdb_cancellation_token.h>
+#include <wdb/wdb_host_binding.h>
+#include <wdb/wdb_output_channel.h>
+#include <wdb/wdb_pending_call.h>
+#include <wdb/wdb_host_call_log.h>
+#include <wdb/wdb_stop_map.h>
 #include <wabt/src/result.h>
 #include <wabt/src/stream.h>
 #include <wabt/src/feature.h>
 #include <wabt/src/interp/interp.h>
 #include <wabt/src/error-formatter.h>
 #include <sstream>
+#include <unordered_map>
 
 namespace wdb {
     class WdbExecutor {
@@ -16,13 +25,64 @@ namespace wdb {
             std::function<void(std::string text)> outputStreamHandler;
             std::function<void(std::string text)> errorStreamHandler;
             std::function<void(wdb::WdbExecutor*)> preSetup;
+            // Optional token stopping the execution from another thread
+            std::shared_ptr<WdbCancellationToken> cancellationToken;
+            // Resource limits, none is checked per instruction
+            uint64_t fuel = UINT64_MAX;
+            uint32_t maxMemoryPages = WABT_MAX_PAGES;
+            // 0 keeps the call stack size of the thread options
+            uint32_t maxCallDepth = 0;
+            uint64_t maxHostCalls = UINT64_MAX;
         };
+
+        // Resource limit stopping the execution
+        enum Limit {
+            NO_LIMIT,
+            FUEL_LIMIT,
+            CALL_DEPTH_LIMIT,
+            HOST_CALLS_LIMIT
+        };
+
+        // Status of a bounded execution
+        enum ExecuteStatus {
+            EXECUTE_RETURNED,
+            EXECUTE_YIELDED,
+            EXECUTE_CANCELLED,
+            EXECUTE_SUSPENDED,
+            EXECUTE_LIMIT_EXCEEDED,
+            EXECUTE_TRAPPED,
+            EXECUTE_FAILED
+        };
+
+        // Read-only range of a memory, invalidated when the program runs
+        struct MemoryView {
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+        };
+
+        // Writable range of a memory, invalidated when the program runs
+        struct MutableMemoryView {
+            uint8_t* data = nullptr;
+            size_t size = 0;
+        };
+
+        // Byte order of typed memory reads
+        enum ByteOrder {
+            LITTLE_ENDIAN_ORDER,
+            BIG_ENDIAN_ORDER
+        };
+
         /**
          * Construct an executor
          * @param options
          */
         WdbExecutor(WdbExecutor::Options options);
 
+        /**
+         * Destroy the environment and thread
+         */
+        virtual ~WdbExecutor();
+
         /**
          * Get program stack
          * @param index
@@ -56,6 +116,94 @@ namespace wdb {
          */
         int GetMemoriesCount();
 
+        /**
+         * Get a read-only view of a memory range
+         * @param memoryIndex
+         * @param offset
+         * @param size
+         * @param view
+         * @return result, error if the range is out of bounds
+         */
+        wabt::Result GetMemoryView(int memoryIndex, uint64_t offset, uint64_t size, MemoryView* view);
+
+        /**
+         * Get a writable view of a memory range
+         * @param memoryIndex
+         * @param offset
+         * @param size
+         * @param view
+         * @return result, error if the range is out of bounds
+         */
+        wabt::Result GetMutableMemoryView(int memoryIndex, uint64_t offset, uint64_t size, MutableMemoryView* view);
+
+        /**
+         * Copy a buffer into a memory range
+         * @param memoryIndex
+         * @param offset
+         * @param buffer
+         * @param size
+         * @return result, error if the range is out of bounds
+         */
+        wabt::Result WriteMemory(int memoryIndex, uint64_t offset, const void* buffer, size_t size);
+
+        /**
+         * Copy a memory range into a buffer
+         * @param memoryIndex
+         * @param offset
+         * @param buffer
+         * @param size
+         * @return result, error if the range is out of bounds
+         */
+        wabt::Result CopyMemory(int memoryIndex, uint64_t offset, void* buffer, size_t size);
+
+        /**
+         * Read typed values from a memory
+         * @param memoryIndex
+         * @param offset
+         * @param value
+         * @param order byte order of the value in memory
+         * @return result, error if the value is out of bounds
+         */
+        wabt::Result ReadMemoryI32(int memoryIndex, uint64_t offset, uint32_t* value, ByteOrder order = LITTLE_ENDIAN_ORDER);
+        wabt::Result ReadMemoryI64(int memoryIndex, uint64_t offset, uint64_t* value, ByteOrder order = LITTLE_ENDIAN_ORDER);
+        wabt::Result ReadMemoryF32(int memoryIndex, uint64_t offset, float* value, ByteOrder order = LITTLE_ENDIAN_ORDER);
+        wabt::Result ReadMemoryF64(int memoryIndex, uint64_t offset, double* value, ByteOrder order = LITTLE_ENDIAN_ORDER);
+        wabt::Result ReadMemoryV128(int memoryIndex, uint64_t offset, wabt::v128* value, ByteOrder order = LITTLE_ENDIAN_ORDER);
+
+        /**
+         * Search a memory for a byte pattern
+         * @param memoryIndex
+         * @param pattern
+         * @param patternSize
+         * @param matches sorted offsets of the matches
+         * @param options
+         * @return result
+         */
+        wabt::Result SearchMemoryBytes(int memoryIndex, const void* pattern, size_t patternSize,
+                                       std::vector<uint64_t>* matches,
+                                       WdbMemorySearch::Options options = WdbMemorySearch::Options());
+
+        /**
+         * Search a memory for aligned values within [min, max], use min == max to search a value
+         * @param memoryIndex
+         * @param min
+         * @param max
+         * @param isSigned compare integers as signed
+         * @param matches sorted offsets of the matches
+         * @param options
+         * @return result
+         */
+        wabt::Result SearchMemoryI32(int memoryIndex, uint32_t min, uint32_t max, bool isSigned,
+                                     std::vector<uint64_t>* matches,
+                                     WdbMemorySearch::Options options = WdbMemorySearch::Options());
+        wabt::Result SearchMemoryI64(int memoryIndex, uint64_t min, uint64_t max, bool isSigned,
+                                     std::vector<uint64_t>* matches,
+                                     WdbMemorySearch::Options options = WdbMemorySearch::Options());
+        wabt::Result SearchMemoryF32(int memoryIndex, float min, float max, std::vector<uint64_t>* matches,
+                                     WdbMemorySearch::Options options = WdbMemorySearch::Options());
+        wabt::Result SearchMemoryF64(int memoryIndex, double min, double max, std::vector<uint64_t>* matches,
+                                     WdbMemorySearch::Options options = WdbMemorySearch::Options());
+
         /**
          * Get module at index
          * @param index
@@ -75,6 +223,52 @@ namespace wdb {
          */
         wabt::Result SetupEnvironment(std::vector<uint8_t> *fileData);
 
+        /**
+         * Setup the program environment from module bytes that are not copied
+         * @param data
+         * @param size
+         * @return result
+         */
+        wabt::Result SetupEnvironment(const uint8_t* data, size_t size);
+
+        /**
+         * Setup the program environment by cloning the module loaded by another executor,
+         * both environments must have been given the same host functions before loading
+         * @param prepared executor that has not run yet
+         * @return result
+         */
+        wabt::Result CloneEnvironment(WdbExecutor* prepared);
+
+        /**
+         * Add host functions with the names and signatures of the ones another executor was given
+         * before loading, calling them traps, so that an executor that never runs can be cloned from
+         * @param from executor with a loaded module
+         * @return result, error if the host functions cannot be reproduced
+         */
+        wabt::Result CopyHostImports(WdbExecutor* from);
+
+        /**
+         * Serialize the host functions given before loading, an image only loads with the same ones
+         * @param prefix output bytes
+         */
+        void GetHostPrefix(std::vector<uint8_t>* prefix);
+
+        /**
+         * Serialize the loaded module into an image that can setup an environment without reading the binary
+         * @param image output bytes
+         * @return result
+         */
+        wabt::Result SaveEnvironmentImage(std::vector<uint8_t>* image);
+
+        /**
+         * Setup the program environment from an image, the host functions given
+         * before loading must match the ones of the saved environment
+         * @param data
+         * @param size
+         * @return result
+         */
+        wabt::Result LoadEnvironmentImage(const uint8_t* data, size_t size);
+
         /**
          * Append host function
          * @param hostName
@@ -88,6 +282,41 @@ namespace wdb {
                                                                     const wabt::interp::TypedValues& args,
                                                                     wabt::interp::TypedValues& results)> callback);
 
+        /**
+         * Append a host function that may complete after returning, the execution is then
+         * suspended until the call completes, any executor resumes it by running again
+         * @param hostName
+         * @param funcName
+         * @param funcSignature
+         * @param callback completes the pending call now or later
+         */
+        wabt::Result AppendAsyncHostFuncExport(std::string hostName, std::string funcName,
+                                               wabt::interp::FuncSignature funcSignature,
+                                               std::function<void(const wabt::interp::TypedValues& args,
+                                                                  std::shared_ptr<WdbPendingCall> call)> callback);
+
+        /**
+         * Get the host call the execution is suspended on
+         * @return pending call or nullptr
+         */
+        std::shared_ptr<WdbPendingCall> GetPendingCall() const { return m_pendingCall; }
+
+        /**
+         * Bind a typed host function, the signature is derived from the function type
+         * e.g. BindHost<int32_t(int32_t, double)>("env", "f", callable)
+         * @tparam Signature function type
+         * @param hostName
+         * @param funcName
+         * @param callable
+         * @return result
+         */
+        template <typename Signature, typename F>
+        wabt::Result BindHost(std::string hostName, std::string funcName, F callable) {
+            return AppendHostFuncExport(std::move(hostName), std::move(funcName),
+                                        WdbHostBinding<Signature>::GetSignature(),
+                                        WdbHostBinding<Signature>::Wrap(std::move(callable)));
+        }
+
         /**
          * Get the main module
          * @return module
@@ -101,6 +330,25 @@ namespace wdb {
          */
         std::vector<wabt::interp::Export> GetExportedModuleFunctions(wabt::interp::Module* module);
 
+        /**
+         * Find an export of a module by name through the module export hash
+         * @param module
+         * @param name
+         * @param kind
+         * @return export owned by the module or nullptr
+         */
+        const wabt::interp::Export* FindExport(wabt::interp::Module* module, const std::string& name,
+                                               wabt::ExternalKind kind = wabt::ExternalKind::Func);
+
+        /**
+         * Get the exports of one kind in a module
+         * @param module
+         * @param kind
+         * @return exports owned by the module
+         */
+        const std::vector<const wabt::interp::Export*>& GetModuleExports(wabt::interp::Module* module,
+                                                                         wabt::ExternalKind kind);
+
         /**
          * Search for exported function in a module
          * @param module
@@ -125,6 +373,20 @@ namespace wdb {
          */
         wabt::interp::FuncSignature* GetFunctionSignature(wabt::Index index);
 
+        /**
+         * Get the name of a function, from the debug names when available
+         * @param index
+         * @return function name
+         */
+        std::string GetFunctionName(wabt::Index index);
+
+        /**
+         * Get the defined function whose code contains an istream offset
+         * @param offset
+         * @return function index or kInvalidIndex
+         */
+        wabt::Index GetFunctionAt(wabt::interp::IstreamOffset offset);
+
         /**
          * Set the program counter at the function index
          * @param function
@@ -137,6 +399,81 @@ namespace wdb {
          */
         virtual wabt::Result Execute();
 
+        /**
+         * Execute instructions until the main function returns or the budget is spent,
+         * a yielded or suspended execution is resumed by calling again
+         * @param instructions maximum number of instructions
+         * @param microseconds maximum time, 0 for no time limit
+         * @return execute status
+         */
+        ExecuteStatus ExecuteFor(uint64_t instructions, uint64_t microseconds = 0);
+
+        /**
+         * Get the resource limit that stopped the execution
+         * @return limit or NO_LIMIT
+         */
+        Limit GetExceededLimit() const { return m_exceededLimit; }
+
+        /**
+         * Get the fuel left
+         * @return remaining instructions
+         */
+        uint64_t GetFuel() const { return m_fuel; }
+
+        /**
+         * Refuel an execution, resumes one stopped by the fuel limit
+         * @param fuel instructions
+         */
+        void SetFuel(uint64_t fuel);
+
+        /**
+         * Get the number of instructions executed, exact at host calls while recording or replaying
+         * whichever executor drives the execution
+         * @return instructions
+         */
+        uint64_t GetInstructionCount() const { return m_instructionCount; }
+
+        /**
+         * Log every host call to a file, with the memory host functions write through
+         * WriteMemory or a mutable memory view
+         * @param fileName
+         * @return result
+         */
+        wabt::Result RecordHostCalls(std::string fileName);
+
+        /**
+         * Return the host call results of a recorded log instead of calling the host functions,
+         * the host functions must be appended in the same order as when recording
+         * @param fileName
+         * @return result
+         */
+        wabt::Result ReplayHostCalls(std::string fileName);
+
+        /**
+         * Stop recording or replaying
+         * @return result of writing the log
+         */
+        wabt::Result CloseHostCallLog();
+
+        /**
+         * Keep the host calls in memory, executing again from a snapshot returns the kept results
+         * instead of calling the host functions again, e.g. to reverse the execution
+         * @param keep
+         */
+        void KeepHostCallHistory(bool keep);
+
+        /**
+         * Check if a replayed execution made a host call not matching the log, the call traps
+         * @return true if diverged
+         */
+        bool ReplayHasDiverged() const { return m_replayDiverged; }
+
+        /**
+         * Set the token stopping the execution from another thread
+         * @param token
+         */
+        void SetCancellationToken(std::shared_ptr<WdbCancellationToken> token) { m_cancellationToken = std::move(token); }
+
         /**
          * Get main function returned values
          * @return Errors
@@ -168,23 +505,90 @@ namespace wdb {
          */
         void SetErrorStreamHandler(std::function<void(std::string)> handler) { m_errorStreamHandler = handler; }
 
+        /**
+         * Buffer output text in a channel instead of passing it to the output stream handler
+         * @param channel not owned, nullptr to use the handler
+         */
+        void SetOutputChannel(WdbOutputChannel* channel) { m_outputChannel = channel; }
+
+        /**
+         * Buffer error text in a channel instead of passing it to the error stream handler
+         * @param channel not owned, nullptr to use the handler
+         */
+        void SetErrorChannel(WdbOutputChannel* channel) { m_errorChannel = channel; }
+
         /**
          * Post output text
          * @param text
          */
         void PostOutput(std::string text);
 
+        /**
+         * Post output text without building a string when a channel is set
+         * @param data
+         * @param size
+         */
+        void PostOutput(const char* data, size_t size);
+
         /**
          * Post error text
          * @param text
          */
         void PostError(std::string text);
 
+        /**
+         * Post error text without building a string when a channel is set
+         * @param data
+         * @param size
+         */
+        void PostError(const char* data, size_t size);
+
+        /**
+         * Drop posted output and error text, e.g. while re-executing instructions
+         * @param muted
+         */
+        void SetOutputMuted(bool muted) { m_outputMuted = muted; }
+
         /**
          * Check if main function is set
          * @return true if is set
          */
         bool MainFunctionIsSet() const { return m_mainFunction; }
+
+        /**
+         * Follow the frames of the calls made by the main function so that snapshots can be taken inside calls,
+         * calls and returns then run one at a time
+         * @return result, error when already inside a call or the istream cannot be decoded
+         */
+        wabt::Result TrackCallFrames();
+
+        /**
+         * Follow the memory pages written from here on so that Snapshot and Restore only go through the pages
+         * written since the previous snapshot instead of comparing every page, at the cost of running every
+         * store, atomic and bulk memory instruction one at a time, host functions must write memory
+         * through the executor, see GetMutableMemoryView
+         * @return result, error when the istream cannot be decoded
+         */
+        wabt::Result TrackDirtyPages();
+
+        /**
+         * Save the memories, tables, globals, stack, pc, resource usage and host call positions,
+         * memory pages unchanged since the last snapshot taken or restored are shared with it
+         * @param snapshot
+         * @return result, error when paused inside an untracked call made by the main function
+         * or on a suspended host call
+         */
+        wabt::Result Snapshot(WdbSnapshot* snapshot);
+
+        /**
+         * Restore a snapshot of this executor, only memory pages written since are copied when the snapshot
+         * was taken while tracking dirty pages and pages that differ otherwise, see TrackDirtyPages,
+         * a host call suspended since is abandoned and the following host calls are replayed
+         * from the kept history or the replayed log, see KeepHostCallHistory
+         * @param snapshot
+         * @return result
+         */
+        wabt::Result Restore(const WdbSnapshot& snapshot);
     protected:
         wabt::interp::Thread* m_thread = nullptr;
         wabt::interp::Environment* m_env = nullptr;
@@ -199,12 +603,287 @@ namespace wdb {
          * Mark main has returned
          */
         void SetMainFunctionReturned() { m_mainReturned = true; };
+
+        /**
+         * Run instructions within the fuel limit, all executors run through here,
+         * fuel is only charged for a batch that completed
+         * @param count
+         * @return interpreter result, a trap when a resource limit is exceeded, see GetRunLimit
+         */
+        wabt::interp::Result RunInstructions(int count);
+
+        /**
+         * Get the resource limit that stopped the last RunInstructions, a trap of the program otherwise,
+         * the execution can continue after refueling a run stopped by FUEL_LIMIT
+         * @return limit or NO_LIMIT
+         */
+        Limit GetRunLimit() const { return m_runLimit; }
+
+        /**
+         * Get the function an indirect call at pc is about to call, before running it
+         * @param instruction call_indirect or return_call_indirect at pc
+         * @return function index or kInvalidIndex
+         */
+        wabt::Index GetIndirectCallee(const WdbInstructionDecoder::Instruction& instruction);
+
+        /**
+         * Check if an instruction at pc is about to call a host function in place,
+         * a host function reached through return_call_indirect also returns from the current function
+         * @param instruction
+         * @return true for call host, and indirect calls to a host function
+         */
+        bool IsHostCall(const WdbInstructionDecoder::Instruction& instruction);
+
+        /**
+         * Called when a host function, or the completion of a suspended one, gets a mutable view of memory
+         * through the executor, e.g. with WriteMemory, the view is assumed written
+         * @param memoryIndex
+         * @param offset
+         * @param size
+         */
+        virtual void OnHostMemoryWrite(wabt::Index memoryIndex, uint64_t offset, uint64_t size) {}
+
+        /**
+         * Check if the thread may be inside a call made by the main function,
+         * the call stack is only known before main runs and after it returns
+         * @return true if a snapshot could miss call frames
+         */
+        virtual bool MayBeInCall();
     private:
         wabt::interp::DefinedModule* m_mainModule = nullptr;
         wabt::interp::DefinedFunc* m_mainFunction = nullptr;
         bool m_mainReturned = false;
+        // Environment state before loading the main module
+        wabt::interp::Environment::MarkPoint m_setupMark;
         std::function<void(std::string)> m_outputStreamHandler;
         std::function<void(std::string)> m_errorStreamHandler;
+        WdbOutputChannel* m_outputChannel = nullptr;
+        WdbOutputChannel* m_errorChannel = nullptr;
+        bool m_outputMuted = false;
+        std::shared_ptr<WdbCancellationToken> m_cancellationToken;
+        // Resource limits
+        uint64_t m_fuel;
+        uint32_t m_maxMemoryPages;
+        uint32_t m_maxCallDepth;
+        uint64_t m_maxHostCalls;
+        uint64_t m_hostCalls = 0;
+        Limit m_exceededLimit = NO_LIMIT;
+        Limit m_runLimit = NO_LIMIT;
+        // Asynchronous host calls
+        int m_asyncHostFuncCount = 0;
+        WdbStopMap m_hostCallMap;
+        bool m_hostCallMapFailed = false;
+        std::shared_ptr<WdbPendingCall> m_pendingCall;
+        std::vector<wabt::Type> m_pendingResultTypes;
+        // Host call record and replay
+        WdbHostCallLog m_hostCallLog;
+        uint32_t m_hostFuncCount = 0;
+        uint64_t m_instructionCount = 0;
+        bool m_replayDiverged = false;
+        bool m_pendingRecorded = false;
+        WdbHostCallLog::Entry m_pendingEntry;
+        // Host calls kept in memory and the next one to return when executing again
+        bool m_keepHostCallHistory = false;
+        std::vector<WdbHostCallLog::Entry> m_hostCallHistory;
+        size_t m_hostCallHistoryPosition = 0;
+        // Memory ranges written through the executor by the recorded host call
+        bool m_inHostCall = false;
+        bool m_trackingHostWrites = false;
+        std::vector<WdbHostCallLog::MemoryWrite> m_hostWrites;
+        // Call frames entered by the main function
+        bool m_trackCallFrames = false;
+        WdbStopMap m_callFrameMap;
+        std::vector<WdbSnapshot::Frame> m_callFrames;
+        // Generation of the last write of each memory page, snapshots take the current generation
+        bool m_trackDirtyPages = false;
+        WdbStopMap m_dirtyPageMap;
+        std::vector<std::vector<uint64_t>> m_pageGenerations;
+        uint64_t m_writeGeneration = 1;
+        uint64_t m_trackedSinceGeneration = 0;
+        // Pages of the last snapshot taken or restored and its generation, 0 when not tracking
+        std::vector<std::vector<std::weak_ptr<const std::vector<char>>>> m_sharedPages;
+        uint64_t m_sharedPagesGeneration = 0;
+        // Debug names indexed by function index
+        std::vector<std::string> m_functionNames;
+        // Entry offsets of defined functions sorted by offset
+        std::vector<std::pair<wabt::interp::IstreamOffset, wabt::Index>> m_functionOffsets;
+        // Exports of each module by kind, rebuilt when the exports of a module change
+        struct ExportIndex {
+            const wabt::interp::Export* exports = nullptr;
+            size_t exportCount = 0;
+            std::vector<const wabt::interp::Export*> byKind[wabt::kExternalKindCount];
+        };
+        std::unordered_map<const wabt::interp::Module*, ExportIndex> m_exportIndexes;
+
+        /**
+         * Read debug function names of the main module
+         * @param data
+         * @param size
+         */
+        void ReadFunctionNames(const void* data, size_t size);
+
+        /**
+         * Index the entry offsets of the defined functions
+         */
+        void IndexFunctionOffsets();
+
+        /**
+         * Index the exports of every module
+         */
+        void IndexExports();
+
+        /**
+         * Call a host function, recording or replaying the call
+         * @param function host function in binding order
+         * @param callback
+         * @param func
+         * @param sig
+         * @param args
+         * @param results
+         * @return result
+         */
+        wabt::interp::Result CallHostFunc(uint32_t function,
+                                          const std::function<wabt::interp::Result(const wabt::interp::HostFunc*,
+                                                                                   const wabt::interp::FuncSignature*,
+                                                                                   const wabt::interp::TypedValues&,
+                                                                                   wabt::interp::TypedValues&)>& callback,
+                                          const wabt::interp::HostFunc* func, const wabt::interp::FuncSignature* sig,
+                                          const wabt::interp::TypedValues& args, wabt::interp::TypedValues& results);
+
+        /**
+         * Return the results of the next logged host call
+         * @param function
+         * @param args
+         * @param results
+         * @return logged result
+         */
+        wabt::interp::Result ReplayHostCall(uint32_t function, const wabt::interp::TypedValues& args,
+                                            wabt::interp::TypedValues& results);
+
+        /**
+         * Check if a logged host call is the call about to be made
+         * @param entry
+         * @param function
+         * @param args
+         * @param results
+         * @return true if it matches
+         */
+        bool IsLoggedCall(const WdbHostCallLog::Entry& entry, uint32_t function, const wabt::interp::TypedValues& args,
+                          const wabt::interp::TypedValues& results) const;
+
+        /**
+         * Write the memory a logged host call wrote and return its results
+         * @param entry
+         * @param results
+         * @return logged result
+         */
+        wabt::interp::Result ApplyLoggedCall(const WdbHostCallLog::Entry& entry, wabt::interp::TypedValues& results);
+
+        /**
+         * Write a host call to the log and the history
+         * @param entry
+         */
+        void LogHostCall(const WdbHostCallLog::Entry& entry);
+
+        /**
+         * Take the bytes now in the memory ranges written by the recorded host call
+         * @return memory writes
+         */
+        std::vector<WdbHostCallLog::MemoryWrite> TakeHostWrites();
+
+        /**
+         * Build the map of instructions that may call a host function
+         * @return true if built
+         */
+        bool PrepareHostCallMap();
+
+        /**
+         * Make the call frame map reflect the istream
+         * @return true if the map can be used
+         */
+        bool PrepareCallFrameMap();
+
+        /**
+         * Make the dirty page map reflect the istream
+         * @return true if the map can be used
+         */
+        bool PrepareDirtyPageMap();
+
+        /**
+         * Stamp the pages a memory write at pc is about to write, before running it
+         * @param instruction
+         */
+        void MarkInstructionWrites(const WdbInstructionDecoder::Instruction& instruction);
+
+        /**
+         * Stamp written pages with the current generation
+         * @param memoryIndex
+         * @param offset
+         * @param size
+         */
+        void MarkPagesWritten(wabt::Index memoryIndex, uint64_t offset, uint64_t size);
+
+        /**
+         * Get the generation of the last write of a page
+         * @param memoryIndex
+         * @param page
+         * @return generation, 0 if not written while tracking
+         */
+        uint64_t GetPageGeneration(wabt::Index memoryIndex, uint64_t page) const;
+
+        /**
+         * Share the pages of a snapshot with the next snapshot, the memory holds these pages
+         * @param memories
+         * @param generation generation of the pages, 0 when not tracking
+         */
+        void ShareSnapshotPages(const std::vector<WdbSnapshot::Memory>& memories, uint64_t generation);
+
+        /**
+         * Update the followed frames after running a call or return
+         * @param instruction executed instruction
+         * @param frame frame the instruction entered if it was a call
+         */
+        void UpdateCallFrames(const WdbInstructionDecoder::Instruction& instruction, const WdbSnapshot::Frame& frame);
+
+        /**
+         * Enter a frame by running its call instruction, the call only pushes the return pc
+         * @param frame
+         * @return result
+         */
+        wabt::Result EnterCallFrame(const WdbSnapshot::Frame& frame);
+
+        /**
+         * Push the results of a completed pending call and move past the call instruction at pc
+         * @return EXECUTE_YIELDED when resumed
+         */
+        ExecuteStatus ResumePendingCall();
+
+        /**
+         * Get the up to date export index of a module
+         * @param module
+         * @return export index
+         */
+        const ExportIndex& GetExportIndex(wabt::interp::Module* module);
+
+        /**
+         * Get a read-only view of a whole memory
+         * @param memoryIndex
+         * @param view
+         * @return result
+         */
+        wabt::Result GetWholeMemoryView(int memoryIndex, MemoryView* view);
+
+        /**
+         * Read a value from a memory
+         * @tparam T
+         * @param memoryIndex
+         * @param offset
+         * @param value
+         * @param order
+         * @return result
+         */
+        template <typename T>
+        wabt::Result ReadMemoryValue(int memoryIndex, uint64_t offset, T* value, ByteOrder order);
     };
 }
 
@@ -0,0 +1,132 @@
+#ifndef WDB_WDB_HOST_BINDING_H
+#define WDB_WDB_HOST_BINDING_H
+
+#include <wabt/src/interp/interp.h>
+
+namespace wdb {
+    namespace internal {
+        // Compile time list of argument indexes
+        template <size_t... I>
+        struct IndexSequence {};
+
+        template <size_t N, size_t... I>
+        struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...> {};
+
+        template <size_t... I>
+        struct MakeIndexSequence<0, I...> : IndexSequence<I...> {};
+
+        // Wasm type of a C++ type and conversions from and to interpreter values
+        template <typename T>
+        struct HostValue;
+
+        template <>
+        struct HostValue<int32_t> {
+            static wabt::Type GetType() { return wabt::Type::I32; }
+            static int32_t Get(const wabt::interp::TypedValue& value) { return static_cast<int32_t>(value.get_i32()); }
+            static void Set(wabt::interp::TypedValue* value, int32_t x) { value->set_i32(static_cast<uint32_t>(x)); }
+        };
+
+        template <>
+        struct HostValue<uint32_t> {
+            static wabt::Type GetType() { return wabt::Type::I32; }
+            static uint32_t Get(const wabt::interp::TypedValue& value) { return value.get_i32(); }
+            static void Set(wabt::interp::TypedValue* value, uint32_t x) { value->set_i32(x); }
+        };
+
+        template <>
+        struct HostValue<int64_t> {
+            static wabt::Type GetType() { return wabt::Type::I64; }
+            static int64_t Get(const wabt::interp::TypedValue& value) { return static_cast<int64_t>(value.get_i64()); }
+            static void Set(wabt::interp::TypedValue* value, int64_t x) { value->set_i64(static_cast<uint64_t>(x)); }
+        };
+
+        template <>
+        struct HostValue<uint64_t> {
+            static wabt::Type GetType() { return wabt::Type::I64; }
+            static uint64_t Get(const wabt::interp::TypedValue& value) { return value.get_i64(); }
+            static void Set(wabt::interp::TypedValue* value, uint64_t x) { value->set_i64(x); }
+        };
+
+        template <>
+        struct HostValue<float> {
+            static wabt::Type GetType() { return wabt::Type::F32; }
+            static float Get(const wabt::interp::TypedValue& value) { return value.get_f32(); }
+            static void Set(wabt::interp::TypedValue* value, float x) { value->set_f32(x); }
+        };
+
+        template <>
+        struct HostValue<double> {
+            static wabt::Type GetType() { return wabt::Type::F64; }
+            static double Get(const wabt::interp::TypedValue& value) { return value.get_f64(); }
+            static void Set(wabt::interp::TypedValue* value, double x) { value->set_f64(x); }
+        };
+
+        // Call a host callable with unpacked arguments and store its result
+        template <typename R, typename... Args>
+        struct HostInvoker {
+            template <typename F, size_t... I>
+            static wabt::interp::Result Call(F& callable, const wabt::interp::TypedValues& args,
+                                             wabt::interp::TypedValues& results, IndexSequence<I...>) {
+                results[0].type = HostValue<R>::GetType();
+                HostValue<R>::Set(&results[0], callable(HostValue<Args>::Get(args[I])...));
+                return wabt::interp::Result::Ok;
+            }
+        };
+
+        template <typename... Args>
+        struct HostInvoker<void, Args...> {
+            template <typename F, size_t... I>
+            static wabt::interp::Result Call(F& callable, const wabt::interp::TypedValues& args,
+                                             wabt::interp::TypedValues& results, IndexSequence<I...>) {
+                callable(HostValue<Args>::Get(args[I])...);
+                return wabt::interp::Result::Ok;
+            }
+        };
+
+        template <typename R>
+        struct HostResults {
+            static std::vector<wabt::Type> GetTypes() { return {HostValue<R>::GetType()}; }
+        };
+
+        template <>
+        struct HostResults<void> {
+            static std::vector<wabt::Type> GetTypes() { return {}; }
+        };
+    }
+
+    /**
+     * Host function binding derived from a C++ function type such as int32_t(int32_t, double),
+     * the arguments are passed to the callable without intermediate containers
+     */
+    template <typename Signature>
+    struct WdbHostBinding;
+
+    template <typename R, typename... Args>
+    struct WdbHostBinding<R(Args...)> {
+        /**
+         * Get the function signature of the binding
+         * @return function signature
+         */
+        static wabt::interp::FuncSignature GetSignature() {
+            return wabt::interp::FuncSignature({internal::HostValue<Args>::GetType()...},
+                                               internal::HostResults<R>::GetTypes());
+        }
+
+        /**
+         * Wrap a callable into a host function callback
+         * @param callable
+         * @return callback
+         */
+        template <typename F>
+        static wabt::interp::HostFunc::Callback Wrap(F callable) {
+            return [callable](const wabt::interp::HostFunc* func, const wabt::interp::FuncSignature* sig,
+                              const wabt::interp::TypedValues& args,
+                              wabt::interp::TypedValues& results) mutable {
+                return internal::HostInvoker<R, Args...>::Call(callable, args, results,
+                                                               internal::MakeIndexSequence<sizeof...(Args)>());
+            };
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef WDB_WDB_HOST_CALL_LOG_H
+#define WDB_WDB_HOST_CALL_LOG_H
+
+#include <wdb/wdb_mapped_file.h>
+#include <wabt/src/interp/interp.h>
+#include <cstdio>
+
+namespace wdb {
+    /**
+     * Binary log of host calls, streamed to a file while recording and mapped while replaying
+     */
+    class WdbHostCallLog {
+    public:
+
+        // Memory bytes written by a host function
+        struct MemoryWrite {
+            wabt::Index memoryIndex = 0;
+            uint64_t offset = 0;
+            std::vector<uint8_t> bytes;
+        };
+
+        // Logged host call
+        struct Entry {
+            // Instructions executed before the call
+            uint64_t instructionCount = 0;
+            // Host function in binding order
+            uint32_t function = 0;
+            wabt::interp::Result result = wabt::interp::Result::Ok;
+            wabt::interp::TypedValues args;
+            wabt::interp::TypedValues results;
+            // Memory written through the executor during the call, applied again on replay
+            std::vector<MemoryWrite> memoryWrites;
+        };
+
+        // Where replaying continues, see GetReadPosition
+        struct ReadPosition {
+            size_t offset = 0;
+            uint64_t instructionCount = 0;
+        };
+
+        /**
+         * Compare values by type and the bits of the type
+         * @param a
+         * @param b
+         * @return true if equal
+         */
+        static bool ValuesEqual(const wabt::interp::TypedValues& a, const wabt::interp::TypedValues& b);
+
+        WdbHostCallLog() = default;
+        WdbHostCallLog(const WdbHostCallLog&) = delete;
+        WdbHostCallLog& operator=(const WdbHostCallLog&) = delete;
+
+        /**
+         * Close the log
+         */
+        ~WdbHostCallLog();
+
+        /**
+         * Create a log file and start recording
+         * @param fileName
+         * @return result
+         */
+        wabt::Result OpenForRecording(std::string fileName);
+
+        /**
+         * Open a recorded log file and start replaying
+         * @param fileName
+         * @return result
+         */
+        wabt::Result OpenForReplay(std::string fileName);
+
+        /**
+         * Flush and close the log
+         * @return result of writing the remaining entries
+         */
+        wabt::Result Close();
+
+        /**
+         * Check if recording
+         * @return true if recording
+         */
+        bool IsRecording() const { return m_file != nullptr; }
+
+        /**
+         * Check if replaying
+         * @return true if replaying
+         */
+        bool IsReplaying() const { return m_replaying; }
+
+        /**
+         * Append an entry, entries are written to the file in blocks
+         * @param entry
+         */
+        void Write(const Entry& entry);
+
+        /**
+         * Write the buffered entries to the file
+         * @return result
+         */
+        wabt::Result Flush();
+
+        /**
+         * Read the next entry
+         * @param entry
+         * @return error at the end of the log or if it is corrupt
+         */
+        wabt::Result Read(Entry* entry);
+
+        /**
+         * Get the position of the next entry to read
+         * @return position
+         */
+        ReadPosition GetReadPosition() const;
+
+        /**
+         * Read again from a position returned by GetReadPosition
+         * @param position
+         */
+        void SetReadPosition(const ReadPosition& position);
+    private:
+        // Recording
+        FILE* m_file = nullptr;
+        std::vector<uint8_t> m_buffer;
+        bool m_writeFailed = false;
+        // Replaying
+        WdbMappedFile m_mappedFile;
+        size_t m_readOffset = 0;
+        bool m_replaying = false;
+        // Instruction counts are stored as deltas
+        uint64_t m_lastInstructionCount = 0;
+    };
+}
+
+#endif
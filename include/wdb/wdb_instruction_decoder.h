@@ -0,0 +1,132 @@
+#ifndef WDB_WDB_INSTRUCTION_DECODER_H
+#define WDB_WDB_INSTRUCTION_DECODER_H
+
+#include <wabt/src/opcode.h>
+#include <wabt/src/interp/interp.h>
+#include <string>
+
+namespace wdb {
+    class WdbInstructionDecoder {
+    public:
+
+        // Control flow of an instruction
+        enum Flow {
+            FLOW_NEXT,
+            FLOW_BRANCH,
+            FLOW_BRANCH_IF,
+            FLOW_BRANCH_TABLE,
+            FLOW_CALL,
+            FLOW_CALL_INDIRECT,
+            FLOW_CALL_HOST,
+            FLOW_RETURN,
+            FLOW_RETURN_CALL,
+            FLOW_RETURN_CALL_INDIRECT,
+            FLOW_TRAP,
+            FLOW_DATA
+        };
+
+        // Layout of the immediates following an opcode in the istream
+        enum Immediates {
+            IMM_NONE,
+            IMM_U32,
+            IMM_U32_U32,
+            IMM_U64,
+            IMM_U8,
+            IMM_V128,
+            IMM_DATA,
+            IMM_UNSUPPORTED
+        };
+
+        // Decoded instruction
+        struct Instruction {
+            wabt::interp::IstreamOffset offset;
+            uint32_t length;
+            wabt::Opcode::Enum opcode;
+            Flow flow;
+            // Branch or call target, host function index, or the offset of the table for br_table
+            wabt::interp::IstreamOffset target;
+            // Number of br_table entries including the default one
+            wabt::Index tableSize;
+            Immediates immediates;
+            // Immediate values in istream order, e.g. the memory index and offset of a load,
+            // a v128 spans both and data holds its size, its bytes follow the size in the istream
+            uint64_t operands[2];
+        };
+
+        // Linear memory access of a load, store, atomic or bulk memory instruction
+        struct MemoryAccess {
+            wabt::Index memoryIndex;
+            uint32_t offset;
+            // Size of a fixed access, 0 for a bulk operation
+            uint32_t size;
+            // Position of the address operand from the top of the value stack, 1 being the top
+            uint32_t addressSlot;
+            // Position of the size operand of a bulk operation, 0 otherwise
+            uint32_t sizeSlot;
+            // Position of the source address of memory.copy, 0 otherwise, the source range is read
+            // and the range at the address is written
+            uint32_t sourceSlot;
+            bool reads;
+            bool writes;
+        };
+
+        /**
+         * Create a decoder over an istream
+         * @param istream
+         * @param size
+         */
+        WdbInstructionDecoder(const uint8_t* istream, size_t size);
+
+        /**
+         * Decode the instruction at offset
+         * @param offset
+         * @param instruction
+         * @return result
+         */
+        wabt::Result Decode(wabt::interp::IstreamOffset offset, Instruction* instruction) const;
+
+        /**
+         * Get the target of a br_table entry
+         * @param instruction
+         * @param entry
+         * @return target offset
+         */
+        wabt::interp::IstreamOffset GetTableTarget(const Instruction& instruction, wabt::Index entry) const;
+
+        /**
+         * Format an instruction as text
+         * @param instruction
+         * @return text
+         *
+         * Note: This code is a modified version of the method Environment::Disassemble()
+         */
+        static std::string Format(const Instruction& instruction);
+
+        /**
+         * Get the memory access of an instruction
+         * @param instruction
+         * @param access
+         * @return true if the instruction accesses linear memory
+         */
+        static bool GetMemoryAccess(const Instruction& instruction, MemoryAccess* access);
+
+        /**
+         * Check if an instruction enters or leaves a function
+         * @param instruction
+         * @return true if call, host call, return or tail call
+         */
+        static bool IsCallOrReturn(const Instruction& instruction);
+
+        /**
+         * Check if an instruction may call a host function
+         * @param instruction
+         * @return true if host call or indirect call
+         */
+        static bool MayCallHost(const Instruction& instruction);
+    private:
+        const uint8_t* m_istream;
+        size_t m_size;
+    };
+}
+
+#endif
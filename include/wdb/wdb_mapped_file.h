@@ -0,0 +1,56 @@
+#ifndef WDB_WDB_MAPPED_FILE_H
+#define WDB_WDB_MAPPED_FILE_H
+
+#include <wabt/src/result.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wdb {
+    /**
+     * Read-only memory mapping of a file
+     */
+    class WdbMappedFile {
+    public:
+        WdbMappedFile() = default;
+        WdbMappedFile(const WdbMappedFile&) = delete;
+        WdbMappedFile& operator=(const WdbMappedFile&) = delete;
+
+        /**
+         * Unmap the file
+         */
+        ~WdbMappedFile();
+
+        /**
+         * Map a file
+         * @param fileName
+         * @return result
+         */
+        wabt::Result Open(std::string fileName);
+
+        /**
+         * Unmap the file
+         */
+        void Close();
+
+        /**
+         * Get mapped data
+         * @return data
+         */
+        const uint8_t* GetData() const { return m_data; }
+
+        /**
+         * Get mapped size
+         * @return size
+         */
+        size_t GetSize() const { return m_size; }
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        bool m_mapped = false;
+        // Used where memory mapping is not available
+        std::vector<uint8_t> m_buffer;
+    };
+}
+
+#endif
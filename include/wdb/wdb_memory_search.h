@@ -0,0 +1,54 @@
+#ifndef WDB_WDB_MEMORY_SEARCH_H
+#define WDB_WDB_MEMORY_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wdb {
+    /**
+     * Search kernels over a memory range, vectorized with SSE2 when available
+     */
+    class WdbMemorySearch {
+    public:
+        struct Options {
+            // Stop after this many matches
+            size_t maxMatches = SIZE_MAX;
+            // Threads splitting large ranges, 0 for one per hardware thread
+            unsigned threads = 1;
+        };
+
+        /**
+         * Find the offsets of a byte pattern
+         * @param data
+         * @param size
+         * @param pattern
+         * @param patternSize
+         * @param options
+         * @return sorted match offsets
+         */
+        static std::vector<uint64_t> FindBytes(const uint8_t* data, size_t size, const void* pattern,
+                                               size_t patternSize, const Options& options);
+
+        /**
+         * Find the aligned offsets of values within [min, max], use min == max to find a value
+         * @param data
+         * @param size
+         * @param min
+         * @param max
+         * @param isSigned compare integers as signed
+         * @param options
+         * @return sorted match offsets
+         */
+        static std::vector<uint64_t> FindI32(const uint8_t* data, size_t size, uint32_t min, uint32_t max,
+                                             bool isSigned, const Options& options);
+        static std::vector<uint64_t> FindI64(const uint8_t* data, size_t size, uint64_t min, uint64_t max,
+                                             bool isSigned, const Options& options);
+        static std::vector<uint64_t> FindF32(const uint8_t* data, size_t size, float min, float max,
+                                             const Options& options);
+        static std::vector<uint64_t> FindF64(const uint8_t* data, size_t size, double min, double max,
+                                             const Options& options);
+    };
+}
+
+#endif
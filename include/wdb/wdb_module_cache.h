@@ -0,0 +1,65 @@
+#ifndef WDB_WDB_MODULE_CACHE_H
+#define WDB_WDB_MODULE_CACHE_H
+
+#include <wdb/wdb_executor.h>
+
+namespace wdb {
+    /**
+     * Directory of environment images keyed by a hash of the module bytes and of the host functions,
+     * shared by processes loading the same module, entries keep the module bytes to rule out collisions
+     * and a hash of the image to reject corrupt ones
+     */
+    class WdbModuleCache {
+    public:
+        /**
+         * Set the cache directory, an empty directory disables the cache
+         * @param directory existing directory
+         */
+        void SetDirectory(std::string directory) { m_directory = std::move(directory); }
+
+        /**
+         * Check if the cache is enabled
+         * @return true if enabled
+         */
+        bool IsEnabled() const { return !m_directory.empty(); }
+
+        /**
+         * Hash module or image bytes
+         * @param data
+         * @param size
+         * @return hash
+         */
+        static uint64_t Hash(const uint8_t* data, size_t size);
+
+        /**
+         * Get the cache entry path of a module for the host functions of an executor
+         * @param data
+         * @param size
+         * @param executor
+         * @return path
+         */
+        std::string GetEntryPath(const uint8_t* data, size_t size, WdbExecutor* executor) const;
+
+        /**
+         * Setup the environment of an executor from the cache entry of a module
+         * @param data module bytes
+         * @param size
+         * @param executor
+         * @return result, error if the entry is missing, corrupt or was saved by another interpreter
+         */
+        wabt::Result Load(const uint8_t* data, size_t size, WdbExecutor* executor);
+
+        /**
+         * Store the module loaded by an executor that has not run yet
+         * @param data module bytes
+         * @param size
+         * @param executor
+         * @return result
+         */
+        wabt::Result Store(const uint8_t* data, size_t size, WdbExecutor* executor);
+    private:
+        std::string m_directory;
+    };
+}
+
+#endif
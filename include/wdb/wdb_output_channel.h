@@ -0,0 +1,99 @@
+#ifndef WDB_WDB_OUTPUT_CHANNEL_H
+#define WDB_WDB_OUTPUT_CHANNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace wdb {
+    /**
+     * Ring buffer coalescing output text, flushed to a sink in batches by size,
+     * by time when writing or explicitly. Not thread-safe.
+     */
+    class WdbOutputChannel {
+    public:
+        // Buffered bytes, valid until the next write or consume
+        struct View {
+            const char* data = nullptr;
+            size_t size = 0;
+        };
+
+        /**
+         * Create a channel
+         * @param capacity ring buffer size in bytes
+         */
+        explicit WdbOutputChannel(size_t capacity = 64 * 1024);
+
+        /**
+         * Flush the remaining text
+         */
+        ~WdbOutputChannel();
+
+        /**
+         * Set the sink receiving flushed text, a wrapped buffer is flushed in two views
+         * @param sink
+         */
+        void SetSink(std::function<void(View view)> sink) { m_sink = std::move(sink); }
+
+        /**
+         * Flush when the buffered size reaches a number of bytes, the capacity by default
+         * @param bytes
+         */
+        void SetFlushSize(size_t bytes) { m_flushSize = bytes; }
+
+        /**
+         * Flush on writes made a number of microseconds after the last flush
+         * @param microseconds 0 to disable
+         */
+        void SetFlushInterval(uint32_t microseconds);
+
+        /**
+         * Write text, without a sink the text that does not fit is dropped
+         * @param data
+         * @param size
+         */
+        void Write(const char* data, size_t size);
+
+        /**
+         * Send the buffered text to the sink
+         */
+        void Flush();
+
+        /**
+         * Get the buffered text without copying it
+         * @param first oldest bytes
+         * @param second bytes wrapped at the start of the ring, may be empty
+         */
+        void Peek(View* first, View* second) const;
+
+        /**
+         * Remove the oldest buffered bytes
+         * @param size
+         */
+        void Consume(size_t size);
+
+        /**
+         * Get the number of buffered bytes
+         * @return size
+         */
+        size_t GetBufferedSize() const { return m_size; }
+
+        /**
+         * Get the number of bytes dropped because the buffer was full
+         * @return size
+         */
+        uint64_t GetDroppedSize() const { return m_dropped; }
+    private:
+        std::vector<char> m_buffer;
+        size_t m_start = 0;
+        size_t m_size = 0;
+        size_t m_flushSize;
+        uint64_t m_dropped = 0;
+        uint64_t m_flushIntervalTicks = 0;
+        uint64_t m_lastFlushTicks = 0;
+        std::function<void(View)> m_sink;
+    };
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef WDB_WDB_PENDING_CALL_H
+#define WDB_WDB_PENDING_CALL_H
+
+#include <wabt/src/interp/interp.h>
+#include <mutex>
+
+namespace wdb {
+    /**
+     * Host call completed later by an asynchronous host function, possibly from another thread
+     */
+    class WdbPendingCall {
+    public:
+        /**
+         * Create a pending call
+         * @param args arguments of the call
+         */
+        explicit WdbPendingCall(wabt::interp::TypedValues args) : m_args(std::move(args)) {}
+
+        /**
+         * Get the arguments of the call
+         * @return arguments
+         */
+        const wabt::interp::TypedValues& GetArgs() const { return m_args; }
+
+        /**
+         * Complete the call with its results
+         * @param results
+         */
+        void Complete(wabt::interp::TypedValues results);
+
+        /**
+         * Complete the call with a trap
+         */
+        void Fail();
+
+        /**
+         * Check if the call was completed
+         * @return true if complete
+         */
+        bool IsComplete() const;
+
+        /**
+         * Check if the call was completed with a trap
+         * @return true if failed
+         */
+        bool HasFailed() const;
+
+        /**
+         * Get the results of a completed call
+         * @return results
+         */
+        wabt::interp::TypedValues GetResults() const;
+
+        /**
+         * Set a handler called on the completing thread, or immediately if already complete
+         * @param handler
+         */
+        void SetCompletionHandler(std::function<void()> handler);
+    private:
+        mutable std::mutex m_mutex;
+        wabt::interp::TypedValues m_args;
+        wabt::interp::TypedValues m_results;
+        bool m_complete = false;
+        bool m_failed = false;
+        std::function<void()> m_completionHandler;
+
+        /**
+         * Mark complete and notify
+         * @param lock held lock, released before notifying
+         */
+        void Finish(std::unique_lock<std::mutex>& lock);
+    };
+}
+
+#endif
@@ -2,6 +2,9 @@
 #define WDB_WDB_PROFILER_EXECUTOR_H
 
 #include <wdb/wdb_executor.h>
+#include <wdb/wdb_stop_map.h>
+#include <wdb/wdb_call_tree.h>
+#include <unordered_map>
 
 namespace wdb {
     class WdbProfilerExecutor : public WdbExecutor {
@@ -19,6 +22,12 @@ namespace wdb {
             AVG_TIME_DESC
         };
 
+        // Profiling modes
+        enum Mode {
+            OPCODE_MODE,
+            FUNCTION_MODE
+        };
+
         // Profiling entry struct
         struct ProfilerEntry {
             wabt::Opcode opcode;
@@ -30,6 +39,22 @@ namespace wdb {
             double GetAverageTime() const;
         };
 
+        // Function profiling entry struct
+        struct FunctionEntry {
+            wabt::Index function;
+            std::string name;
+            long count = 0;
+            long inclusiveTime = 0;
+            long exclusiveTime = 0;
+        };
+
+        // Caller to callee edge struct
+        struct CallEdge {
+            wabt::Index caller;
+            wabt::Index callee;
+            long count = 0;
+        };
+
         /**
          * Create a profiler executor
          * @param options
@@ -40,7 +65,14 @@ namespace wdb {
          * Get profiler map
          * @return profiler map
          */
-        std::map<wabt::Opcode, ProfilerEntry> GetProfilerMap() const { return m_profilerMap; };
+        std::map<wabt::Opcode, ProfilerEntry> GetProfilerMap() const;
+
+        /**
+         * Time only one instruction in every interval, 1000 by default, the others run in straight-line batches
+         * and their time is scaled from the timed ones, 1 times every instruction exactly but runs them one at a time
+         * @param interval
+         */
+        void SetTimingInterval(uint32_t interval) { m_timingInterval = interval > 0 ? interval : 1; }
 
         /**
          * Get vector profiler entry sorted
@@ -49,14 +81,111 @@ namespace wdb {
          */
         std::vector<ProfilerEntry> GetProfilerSorted(Sort sort);
 
+        /**
+         * Set profiling mode, opcodes by default
+         * @param mode
+         */
+        void SetMode(Mode mode) { m_mode = mode; }
+
+        /**
+         * Get per function call counts and times recorded in function mode
+         * @return vector of function entries
+         */
+        std::vector<FunctionEntry> GetFunctionProfile();
+
+        /**
+         * Get caller to callee edges recorded in function mode
+         * @return vector of call edges
+         */
+        std::vector<CallEdge> GetCallEdges() const;
+
+        /**
+         * Get exclusive time per call stack in folded flame graph format
+         * @return one "caller;callee nanoseconds" line per stack
+         */
+        std::string GetFoldedStacks();
+
         /**
          * Execute instruction and record profiler information
          * @return result
          */
         wabt::Result Execute();
     private:
-        // Profiler map
-        std::map<wabt::Opcode, ProfilerEntry> m_profilerMap;
+        // Counters of an opcode
+        struct OpcodeCounter {
+            long count = 0;
+            long timedCount = 0;
+            uint64_t timedTicks = 0;
+        };
+
+        // Counters of a function
+        struct FunctionCounter {
+            long count = 0;
+            uint64_t inclusiveTicks = 0;
+            uint64_t exclusiveTicks = 0;
+            uint32_t active = 0;
+        };
+
+        // Active function call
+        struct Frame {
+            wabt::Index function;
+            uint32_t node;
+            uint64_t startTicks;
+            uint64_t childTicks;
+        };
+
+        Mode m_mode = OPCODE_MODE;
+
+        // Counters indexed by opcode
+        std::vector<OpcodeCounter> m_opcodeCounters;
+        uint32_t m_timingInterval = 1000;
+        // Stops at every instruction that does not fall through, runs between them are straight lines
+        WdbStopMap m_blockMap;
+        // Executions of each run keyed by start offset and length, counted into the opcodes when done
+        std::unordered_map<uint64_t, long> m_runCounts;
+
+        // Function profile
+        WdbStopMap m_callMap;
+        std::vector<FunctionCounter> m_functionCounters;
+        std::unordered_map<uint64_t, long> m_callEdges;
+        WdbCallTree m_callTree;
+        std::vector<Frame> m_frames;
+
+        /**
+         * Execute and record opcode information
+         * @return result
+         */
+        wabt::Result ExecuteOpcodes();
+
+        /**
+         * Add the opcodes of the executed runs to the opcode counters
+         */
+        void FlushRunCounts();
+
+        /**
+         * Execute and record function information
+         * @return result
+         */
+        wabt::Result ExecuteFunctions();
+
+        /**
+         * Record entering a function
+         * @param function
+         * @param ticks
+         */
+        void EnterFunction(wabt::Index function, uint64_t ticks);
+
+        /**
+         * Record leaving the current function
+         * @param ticks
+         */
+        void LeaveFunction(uint64_t ticks);
+
+        /**
+         * Get profiler entries of the executed opcodes
+         * @return vector of profiler entries
+         */
+        std::vector<ProfilerEntry> GetProfilerEntries() const;
     };
 }
 
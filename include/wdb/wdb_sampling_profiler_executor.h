@@ -0,0 +1,118 @@
+#ifndef WDB_WDB_SAMPLING_PROFILER_EXECUTOR_H
+#define WDB_WDB_SAMPLING_PROFILER_EXECUTOR_H
+
+#include <wdb/wdb_executor.h>
+#include <wdb/wdb_stop_map.h>
+#include <wdb/wdb_call_tree.h>
+#include <unordered_map>
+
+namespace wdb {
+    class WdbSamplingProfilerExecutor : public WdbExecutor {
+    public:
+
+        // Sampling triggers
+        enum Trigger {
+            INSTRUCTION_TRIGGER,
+            TIMER_TRIGGER
+        };
+
+        // Samples taken at a pc
+        struct PcSample {
+            wabt::interp::IstreamOffset pc;
+            wabt::Index function;
+            long count = 0;
+        };
+
+        // Samples taken in a function
+        struct FunctionSample {
+            wabt::Index function;
+            std::string name;
+            long selfCount = 0;
+            long totalCount = 0;
+        };
+
+        /**
+         * Create a sampling profiler executor
+         * @param options
+         */
+        WdbSamplingProfilerExecutor(WdbExecutor::Options options);
+
+        /**
+         * Sample every number of executed instructions
+         * @param instructions
+         */
+        void SetInstructionInterval(uint32_t instructions);
+
+        /**
+         * Sample every number of microseconds
+         * @param microseconds
+         */
+        void SetTimerInterval(uint32_t microseconds);
+
+        /**
+         * Record the call stack of every sample, enabled by default
+         * @param record
+         */
+        void SetRecordCallStacks(bool record) { m_recordCallStacks = record; }
+
+        /**
+         * Get the number of samples taken
+         * @return samples count
+         */
+        long GetSampleCount() const { return m_sampleCount; }
+
+        /**
+         * Get samples per pc sorted by count
+         * @return vector of pc samples
+         */
+        std::vector<PcSample> GetPcSamples();
+
+        /**
+         * Get samples per function sorted by self count, total counts require call stacks
+         * @return vector of function samples
+         */
+        std::vector<FunctionSample> GetFunctionSamples();
+
+        /**
+         * Get samples per call stack in folded flame graph format
+         * @return one "caller;callee samples" line per stack
+         */
+        std::string GetFoldedStacks();
+
+        /**
+         * Execute instructions and take samples
+         * @return result
+         */
+        wabt::Result Execute();
+    private:
+        Trigger m_trigger = INSTRUCTION_TRIGGER;
+        uint32_t m_instructionInterval = 10000;
+        uint64_t m_timerIntervalTicks = 0;
+        bool m_recordCallStacks = true;
+
+        // Sampling state
+        uint32_t m_untilSample = 0;
+        uint64_t m_nextSampleTicks = 0;
+        long m_sampleCount = 0;
+        std::unordered_map<wabt::interp::IstreamOffset, long> m_pcSamples;
+
+        // Call stack tracking
+        WdbStopMap m_callMap;
+        WdbCallTree m_callTree;
+        std::vector<uint32_t> m_frames;
+
+        /**
+         * Record a sample at the current pc
+         */
+        void TakeSample();
+
+        /**
+         * Update the call stack after running a call or return instruction
+         * @param instruction
+         * @param hostCallee the instruction called a host function in place
+         */
+        void UpdateCallStack(const WdbInstructionDecoder::Instruction& instruction, bool hostCallee);
+    };
+}
+
+#endif
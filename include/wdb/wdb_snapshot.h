@@ -0,0 +1,53 @@
+#ifndef WDB_WDB_SNAPSHOT_H
+#define WDB_WDB_SNAPSHOT_H
+
+#include <wdb/wdb_host_call_log.h>
+#include <wabt/src/interp/interp.h>
+#include <memory>
+
+namespace wdb {
+    /**
+     * Execution state of an executor, taken outside of nested calls unless the executor follows its call frames
+     */
+    struct WdbSnapshot {
+        // Frame entered by a call, re-entered on restore by running its call instruction again
+        struct Frame {
+            wabt::interp::IstreamOffset callOffset = wabt::interp::kInvalidIstreamOffset;
+            // Table element and called function of an indirect call
+            wabt::Index tableIndex = wabt::kInvalidIndex;
+            uint32_t element = 0;
+            wabt::Index function = wabt::kInvalidIndex;
+        };
+
+        // Memory split in pages, the pages a snapshot has in common with the previous one are shared
+        struct Memory {
+            wabt::Limits pageLimits;
+            uint64_t size = 0;
+            std::vector<std::shared_ptr<const std::vector<char>>> pages;
+        };
+
+        // Environment the snapshot was taken from
+        wabt::interp::Environment* env = nullptr;
+        std::vector<Memory> memories;
+        std::vector<std::vector<wabt::Index>> tables;
+        std::vector<wabt::interp::TypedValue> globals;
+        // Value stack, frames of the calls made by the main function and pc
+        std::vector<wabt::interp::Value> values;
+        std::vector<Frame> frames;
+        wabt::interp::IstreamOffset pc = wabt::interp::kInvalidIstreamOffset;
+        wabt::interp::DefinedFunc* mainFunction = nullptr;
+        bool mainReturned = false;
+        uint64_t instructionCount = 0;
+        // Resource usage, the exceeded limit is a WdbExecutor::Limit
+        uint64_t fuel = 0;
+        uint64_t hostCalls = 0;
+        int exceededLimit = 0;
+        // Host calls made so far, in the kept history and in a replayed log
+        size_t hostCallHistoryPosition = 0;
+        WdbHostCallLog::ReadPosition hostCallLogPosition;
+        // Page write generation when taken, 0 when the executor was not tracking dirty pages
+        uint64_t writeGeneration = 0;
+    };
+}
+
+#endif
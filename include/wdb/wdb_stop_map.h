@@ -0,0 +1,76 @@
+#ifndef WDB_WDB_STOP_MAP_H
+#define WDB_WDB_STOP_MAP_H
+
+#include <wdb/wdb_instruction_decoder.h>
+#include <wabt/src/interp/interp.h>
+
+namespace wdb {
+    /**
+     * Control flow graph of the environment istream, used to find how many
+     * instructions can safely run in one batch before reaching a stop offset
+     */
+    class WdbStopMap {
+    public:
+        /**
+         * Decode the istream of an environment and build its control flow graph
+         * @param env
+         * @return result
+         */
+        wabt::Result Build(wabt::interp::Environment* env);
+
+        /**
+         * Check if the map is built for the current istream of an environment
+         * @param env
+         * @return true if built
+         */
+        bool IsBuilt(wabt::interp::Environment* env) const;
+
+        /**
+         * Set the instructions to stop at
+         * @param isStop
+         */
+        void SetStops(std::function<bool(const WdbInstructionDecoder::Instruction&)> isStop);
+
+        /**
+         * Check if an offset is a stop
+         * @param offset
+         * @return true if stop
+         */
+        bool IsStop(wabt::interp::IstreamOffset offset) const;
+
+        /**
+         * Get the number of instructions that can run from offset without
+         * executing a stop instruction
+         * @param offset
+         * @return run length, 0 at a stop and INT_MAX if no stop is reachable
+         */
+        int GetRunLength(wabt::interp::IstreamOffset offset) const;
+
+        /**
+         * Get the decoded instruction at offset
+         * @param offset
+         * @return instruction or nullptr if no instruction starts at offset
+         */
+        const WdbInstructionDecoder::Instruction* GetInstruction(wabt::interp::IstreamOffset offset) const;
+
+        /**
+         * Get the decoded instructions of the istream
+         * @return instructions
+         */
+        const std::vector<WdbInstructionDecoder::Instruction>& GetInstructions() const { return m_instructions; }
+    private:
+        wabt::interp::Environment* m_env = nullptr;
+        size_t m_istreamSize = 0;
+        // Decoded instructions in istream order
+        std::vector<WdbInstructionDecoder::Instruction> m_instructions;
+        // Instruction index at each istream offset
+        std::vector<uint32_t> m_indexAt;
+        // Predecessors of each node in compressed sparse row form
+        std::vector<uint32_t> m_predecessorStart;
+        std::vector<uint32_t> m_predecessors;
+        // Distance of each node to the closest stop
+        std::vector<uint32_t> m_distance;
+    };
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef WDB_WDB_TIMER_H
+#define WDB_WDB_TIMER_H
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define WDB_TIMER_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define WDB_TIMER_TSC 1
+#endif
+
+namespace wdb {
+    class WdbTimer {
+    public:
+        /**
+         * Read the cheapest available timestamp
+         * @return ticks
+         */
+        static inline uint64_t ReadTicks() {
+#ifdef WDB_TIMER_TSC
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+        }
+
+        /**
+         * Get the duration of one tick, calibrated once per process
+         * @return nanoseconds per tick
+         */
+        static double GetNanosecondsPerTick();
+
+        /**
+         * Get the ticks measured between two consecutive reads, calibrated once per process
+         * @return overhead in ticks
+         */
+        static uint64_t GetReadOverhead();
+    };
+}
+
+#endif
@@ -2,19 +2,38 @@
 #define WDB_WDB_WABT_H
 
 #include <wdb/wdb_profiler_executor.h>
+#include <wdb/wdb_sampling_profiler_executor.h>
 #include <wdb/wdb_debugger_executor.h>
 #include <wdb/wdb_code_gen.h>
+#include <wdb/wdb_module_cache.h>
+#include <wdb/wdb_mapped_file.h>
+#include <mutex>
 
 namespace wdb {
+    /**
+     * Loaded module and factory of executors, executors can be created from several threads
+     */
     class WdbWabt {
     public:
         /**
-         * Load module file
+         * Destroy the prepared executor
+         */
+        ~WdbWabt();
+
+        /**
+         * Load module file, the file is mapped read-only and shared by all executors and code generators,
+         * must not be called while executors are being created from other threads
          * @param fileName
          * @return result
          */
         wabt::Result LoadModuleFile(std::string fileName);
 
+        /**
+         * Keep loaded modules in a cache directory shared between processes
+         * @param directory existing directory, empty to disable the cache
+         */
+        void SetCacheDirectory(std::string directory) { m_cache.SetDirectory(std::move(directory)); }
+
         /**
          * Create an isolated executor with a new environment and thread
          * @param options
@@ -36,6 +55,13 @@ namespace wdb {
          */
         wdb::WdbProfilerExecutor* CreateWdbProfilerExecutor(wdb::WdbExecutor::Options options);
 
+        /**
+         * Create an isolated sampling profiler executor with a new environment and thread
+         * @param options
+         * @return Wdb Sampling Profiler Executor
+         */
+        wdb::WdbSamplingProfilerExecutor* CreateWdbSamplingProfilerExecutor(wdb::WdbExecutor::Options options);
+
         /**
          * Create a code generator instance
          * @return code generator
@@ -43,10 +69,15 @@ namespace wdb {
         wdb::WdbCodeGen* CreateCodeGenerator();
     private:
         std::string m_fileName;
-        std::vector<uint8_t> m_fileData;
+        WdbMappedFile m_file;
+        // Executor holding the loaded module, cloned into new executors
+        WdbExecutor* m_preparedExecutor = nullptr;
+        std::mutex m_preparedMutex;
+        // Optional on-disk cache of loaded modules
+        WdbModuleCache m_cache;
 
         /**
-         * Configure executor
+         * Configure executor, cloning the prepared executor when the host functions match
          * @param executor
          * @param options
          * @return result
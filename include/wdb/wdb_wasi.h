@@ -0,0 +1,113 @@
+#ifndef WDB_WDB_WASI_H
+#define WDB_WDB_WASI_H
+
+#include <wdb/wdb_executor.h>
+#include <cstdio>
+#include <map>
+#include <random>
+
+namespace wdb {
+    /**
+     * Subset of the wasi_snapshot_preview1 host module: fd_write, fd_read, clock_time_get,
+     * random_get, args, environ and proc_exit. Guest memory is accessed in place and
+     * standard output and error go to the executor output handlers.
+     */
+    class WdbWasi {
+    public:
+        /**
+         * Create a WASI host with a random seed from the system
+         */
+        WdbWasi();
+
+        /**
+         * Close the files
+         */
+        ~WdbWasi();
+
+        WdbWasi(const WdbWasi&) = delete;
+        WdbWasi& operator=(const WdbWasi&) = delete;
+
+        /**
+         * Set the program arguments
+         * @param args
+         */
+        void SetArgs(std::vector<std::string> args) { m_args = std::move(args); }
+
+        /**
+         * Set the environment variables
+         * @param environment "NAME=value" entries
+         */
+        void SetEnvironment(std::vector<std::string> environment) { m_environment = std::move(environment); }
+
+        /**
+         * Set the text read from standard input
+         * @param input
+         */
+        void SetStdin(std::string input) { m_stdin = std::move(input); m_stdinOffset = 0; }
+
+        /**
+         * Seed random_get for reproducible runs
+         * @param seed
+         */
+        void SetRandomSeed(uint64_t seed) { m_random.seed(seed); }
+
+        /**
+         * Give the guest a host file as a file descriptor
+         * @param fd guest file descriptor, above 2
+         * @param fileName
+         * @param write open for writing instead of reading
+         * @return result
+         */
+        wabt::Result AddFile(uint32_t fd, std::string fileName, bool write);
+
+        /**
+         * Append the WASI functions to an executor, call from the executor preSetup.
+         * The WASI host must outlive the executor.
+         * @param executor
+         * @return result
+         */
+        wabt::Result Bind(WdbExecutor* executor);
+
+        /**
+         * Check if the program called proc_exit, which stops the execution with a trap
+         * @return true if exited
+         */
+        bool HasExited() const { return m_exited; }
+
+        /**
+         * Get the proc_exit code
+         * @return exit code
+         */
+        uint32_t GetExitCode() const { return m_exitCode; }
+    private:
+        std::vector<std::string> m_args;
+        std::vector<std::string> m_environment;
+        std::string m_stdin;
+        size_t m_stdinOffset = 0;
+        std::map<uint32_t, FILE*> m_files;
+        std::mt19937_64 m_random;
+        bool m_exited = false;
+        uint32_t m_exitCode = 0;
+
+        int32_t FdWrite(WdbExecutor* executor, uint32_t fd, uint32_t iovs, uint32_t iovsLength, uint32_t written);
+        int32_t FdRead(WdbExecutor* executor, uint32_t fd, uint32_t iovs, uint32_t iovsLength, uint32_t read);
+        int32_t ClockTimeGet(WdbExecutor* executor, uint32_t clockId, uint64_t precision, uint32_t time);
+        int32_t RandomGet(WdbExecutor* executor, uint32_t buffer, uint32_t length);
+
+        /**
+         * Write the sizes of a list of strings
+         * @return errno
+         */
+        int32_t StringsSizesGet(WdbExecutor* executor, const std::vector<std::string>& strings,
+                                uint32_t count, uint32_t bufferSize);
+
+        /**
+         * Write a list of strings and the pointers to them
+         * @return errno
+         */
+        int32_t StringsGet(WdbExecutor* executor, const std::vector<std::string>& strings,
+                           uint32_t pointers, uint32_t buffer);
+    };
+}
+
+#endif
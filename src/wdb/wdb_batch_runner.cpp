@@ -0,0 +1,112 @@
+#include <wdb/wdb_batch_runner.h>
+#include <algorithm>
+#include <deque>
+#include <thread>
+
+namespace wdb {
+    namespace {
+        // Job indexes of a worker, the owner takes from the front and thieves from the back
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<size_t> jobs;
+        };
+
+        /**
+         * Take a job from a queue
+         * @param queue
+         * @param steal take from the back
+         * @param job
+         * @return true if a job was taken
+         */
+        bool TakeJob(WorkQueue &queue, bool steal, size_t *job) {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(queue.jobs.empty()) {
+                return false;
+            }
+            if(steal) {
+                *job = queue.jobs.back();
+                queue.jobs.pop_back();
+            } else {
+                *job = queue.jobs.front();
+                queue.jobs.pop_front();
+            }
+            return true;
+        }
+    }
+
+    WdbBatchRunner::WdbBatchRunner(wdb::WdbWabt *wabt) : m_wabt(wabt) {}
+
+    std::vector<WdbBatchRunner::JobResult> WdbBatchRunner::Run(const std::vector<Job> &jobs) {
+        std::vector<JobResult> results(jobs.size());
+        size_t threads = m_threadCount != 0 ? m_threadCount : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::max<size_t>(1, std::min(threads, jobs.size()));
+        // Deal the jobs to the workers in contiguous ranges
+        std::vector<WorkQueue> queues(threads);
+        for(size_t i = 0; i < jobs.size(); i++) {
+            queues[i * threads / jobs.size()].jobs.push_back(i);
+        }
+        auto work = [&](size_t worker) {
+            size_t job;
+            while(true) {
+                // Own jobs first, then steal from the other workers
+                bool found = TakeJob(queues[worker], false, &job);
+                for(size_t i = 1; !found && i < threads; i++) {
+                    found = TakeJob(queues[(worker + i) % threads], true, &job);
+                }
+                // Queues only shrink, no job is left once all are empty
+                if(!found) {
+                    return;
+                }
+                results[job] = RunJob(jobs[job]);
+            }
+        };
+        std::vector<std::thread> workers;
+        for(size_t i = 1; i < threads; i++) {
+            workers.emplace_back(work, i);
+        }
+        work(0);
+        for(auto &worker : workers) {
+            worker.join();
+        }
+        return results;
+    }
+
+    WdbBatchRunner::JobResult WdbBatchRunner::RunJob(const Job &job) {
+        JobResult jobResult;
+        // Chain the job host bindings after the common ones and collect the output of the job,
+        // the handlers own what they use since they may be kept past the job
+        WdbExecutor::Options options = m_options;
+        auto preSetup = m_options.preSetup;
+        auto jobPreSetup = job.preSetup;
+        options.preSetup = [preSetup, jobPreSetup](wdb::WdbExecutor *executor) {
+            if(preSetup) {
+                preSetup(executor);
+            }
+            if(jobPreSetup) {
+                jobPreSetup(executor);
+            }
+        };
+        auto output = std::make_shared<std::string>();
+        auto error = std::make_shared<std::string>();
+        options.outputStreamHandler = [output](std::string text) {
+            *output += text;
+        };
+        options.errorStreamHandler = [error](std::string text) {
+            *error += text;
+        };
+        WdbExecutor *executor = m_wabt->CreateWdbExecutor(options);
+        if(!executor) {
+            return jobResult;
+        }
+        // Run the exported function
+        const wabt::interp::Export *e = executor->FindExport(executor->GetMainModule(), job.exportName);
+        if(e && wabt::Succeeded(executor->SetMainFunction(executor->GetFunction(e->index)))
+           && wabt::Succeeded(executor->Execute())) {
+            jobResult.result = executor->GetMainFunctionReturnedValues(jobResult.values);
+        }
+        delete executor;
+        jobResult.output = std::move(*output);
+        jobResult.error = std::move(*error);
+        return jobResult;
+    }
+}
@@ -0,0 +1,442 @@
+#include <wdb/wdb_breakpoint_expression.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace wdb {
+    namespace {
+        // Binary operators, longer tokens first so that they match before their prefixes
+        struct BinaryOperator {
+            const char* token;
+            int precedence;
+            int code;
+        };
+
+        // Memory loads by name
+        struct Load {
+            const char* name;
+            int code;
+        };
+    }
+
+    // Recursive descent parser emitting postfix code
+    class WdbBreakpointExpression::Parser {
+    public:
+        Parser(const std::string& text, std::vector<Op>* code) : m_text(text), m_code(code) {}
+
+        bool Parse() {
+            if(!ParseBinary(1)) {
+                return false;
+            }
+            SkipSpaces();
+            if(m_position != m_text.size()) {
+                return Fail("unexpected '" + m_text.substr(m_position, 1) + "'");
+            }
+            return true;
+        }
+
+        const std::string& GetError() const { return m_error; }
+    private:
+        const std::string& m_text;
+        std::vector<Op>* m_code;
+        size_t m_position = 0;
+        std::string m_error;
+
+        bool Fail(const std::string& message) {
+            if(m_error.empty()) {
+                m_error = message + " at " + std::to_string(m_position);
+            }
+            return false;
+        }
+
+        void SkipSpaces() {
+            while(m_position < m_text.size() && isspace(static_cast<unsigned char>(m_text[m_position]))) {
+                m_position++;
+            }
+        }
+
+        bool Accept(const char* token) {
+            SkipSpaces();
+            size_t length = strlen(token);
+            if(m_text.compare(m_position, length, token) == 0) {
+                m_position += length;
+                return true;
+            }
+            return false;
+        }
+
+        void Emit(OpCode code, int64_t operand = 0) {
+            m_code->push_back(Op{code, operand});
+        }
+
+        const BinaryOperator* MatchBinary(int minPrecedence) {
+            static const BinaryOperator operators[] = {
+                    {"||", 1, OP_OR_ELSE}, {"&&", 2, OP_AND_THEN}, {"==", 6, OP_EQ}, {"!=", 6, OP_NE},
+                    {"<=", 7, OP_LE}, {">=", 7, OP_GE}, {"<<", 8, OP_SHL}, {">>", 8, OP_SHR},
+                    {"|", 3, OP_OR}, {"^", 4, OP_XOR}, {"&", 5, OP_AND}, {"<", 7, OP_LT}, {">", 7, OP_GT},
+                    {"+", 9, OP_ADD}, {"-", 9, OP_SUB}, {"*", 10, OP_MUL}, {"/", 10, OP_DIV}, {"%", 10, OP_REM}
+            };
+            SkipSpaces();
+            for(const BinaryOperator &op : operators) {
+                size_t length = strlen(op.token);
+                if(m_text.compare(m_position, length, op.token) == 0) {
+                    return op.precedence >= minPrecedence ? &op : nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+        // Precedence climbing, all binary operators are left associative
+        bool ParseBinary(int minPrecedence) {
+            if(!ParseUnary()) {
+                return false;
+            }
+            const BinaryOperator *op;
+            while((op = MatchBinary(minPrecedence)) != nullptr) {
+                m_position += strlen(op->token);
+                if(op->code == OP_AND_THEN || op->code == OP_OR_ELSE) {
+                    // Jump over the right operand when the left one decides the result
+                    size_t jump = m_code->size();
+                    Emit(static_cast<OpCode>(op->code));
+                    if(!ParseBinary(op->precedence + 1)) {
+                        return false;
+                    }
+                    Emit(OP_BOOL);
+                    (*m_code)[jump].operand = static_cast<int64_t>(m_code->size());
+                    continue;
+                }
+                if(!ParseBinary(op->precedence + 1)) {
+                    return false;
+                }
+                Emit(static_cast<OpCode>(op->code));
+            }
+            return true;
+        }
+
+        bool ParseUnary() {
+            if(Accept("-")) {
+                if(!ParseUnary()) {
+                    return false;
+                }
+                Emit(OP_NEG);
+                return true;
+            }
+            if(Accept("!")) {
+                if(!ParseUnary()) {
+                    return false;
+                }
+                Emit(OP_NOT);
+                return true;
+            }
+            if(Accept("~")) {
+                if(!ParseUnary()) {
+                    return false;
+                }
+                Emit(OP_BIT_NOT);
+                return true;
+            }
+            return ParsePrimary();
+        }
+
+        bool ParseNumber(int64_t* value) {
+            SkipSpaces();
+            size_t start = m_position;
+            int base = 10;
+            if(m_text.compare(m_position, 2, "0x") == 0 || m_text.compare(m_position, 2, "0X") == 0) {
+                base = 16;
+                m_position += 2;
+            }
+            uint64_t number = 0;
+            size_t digits = 0;
+            while(m_position < m_text.size() && isxdigit(static_cast<unsigned char>(m_text[m_position]))) {
+                char c = static_cast<char>(tolower(m_text[m_position]));
+                int digit = isdigit(static_cast<unsigned char>(c)) ? c - '0' : c - 'a' + 10;
+                if(digit >= base) {
+                    break;
+                }
+                number = number * base + digit;
+                m_position++;
+                digits++;
+            }
+            if(digits == 0) {
+                m_position = start;
+                return Fail("expected a number");
+            }
+            *value = static_cast<int64_t>(number);
+            return true;
+        }
+
+        bool ParseIndex(bool negative, int64_t* index) {
+            if(!Accept("[")) {
+                return Fail("expected '['");
+            }
+            if(negative && !Accept("-")) {
+                return Fail("expected a negative stack slot");
+            }
+            if(!ParseNumber(index) || !Accept("]")) {
+                return Fail("expected ']'");
+            }
+            if(negative && *index == 0) {
+                return Fail("stack slots start at -1");
+            }
+            return true;
+        }
+
+        bool ParsePrimary() {
+            static const Load loads[] = {
+                    {"i8", OP_LOAD_I8}, {"u8", OP_LOAD_U8}, {"i16", OP_LOAD_I16}, {"u16", OP_LOAD_U16},
+                    {"i32", OP_LOAD_I32}, {"u32", OP_LOAD_U32}, {"i64", OP_LOAD_I64}
+            };
+            if(Accept("(")) {
+                if(!ParseBinary(1)) {
+                    return false;
+                }
+                return Accept(")") || Fail("expected ')'");
+            }
+            SkipSpaces();
+            if(m_position < m_text.size() && isdigit(static_cast<unsigned char>(m_text[m_position]))) {
+                int64_t value;
+                if(!ParseNumber(&value)) {
+                    return false;
+                }
+                Emit(OP_CONST, value);
+                return true;
+            }
+            // Read a name
+            size_t start = m_position;
+            while(m_position < m_text.size() && isalnum(static_cast<unsigned char>(m_text[m_position]))) {
+                m_position++;
+            }
+            std::string name = m_text.substr(start, m_position - start);
+            int64_t index;
+            if(name == "stack" || name == "stack64") {
+                if(!ParseIndex(true, &index)) {
+                    return false;
+                }
+                Emit(name == "stack" ? OP_STACK32 : OP_STACK64, index);
+                return true;
+            }
+            if(name == "global") {
+                if(!ParseIndex(false, &index)) {
+                    return false;
+                }
+                Emit(OP_GLOBAL, index);
+                return true;
+            }
+            for(const Load &load : loads) {
+                if(name == load.name) {
+                    if(!Accept("[") || !ParseBinary(1)) {
+                        return Fail("expected '[' address ']'");
+                    }
+                    if(!Accept("]")) {
+                        return Fail("expected ']'");
+                    }
+                    Emit(static_cast<OpCode>(load.code));
+                    return true;
+                }
+            }
+            m_position = start;
+            return Fail(name.empty() ? "expected an operand" : "unknown name '" + name + "'");
+        }
+    };
+
+    wabt::Result WdbBreakpointExpression::Compile(const std::string &text, std::string *error) {
+        m_code.clear();
+        Parser parser(text, &m_code);
+        if(!parser.Parse()) {
+            m_code.clear();
+            if(error) {
+                *error = parser.GetError();
+            }
+            return wabt::Result::Error;
+        }
+        // Size the evaluation stack once, a jump leaves the depth the code after its target expects
+        size_t depth = 0;
+        m_maxDepth = 0;
+        for(const Op &op : m_code) {
+            if(op.code <= OP_GLOBAL) {
+                depth++;
+            } else if(op.code >= OP_MUL) {
+                depth--;
+            }
+            m_maxDepth = std::max(m_maxDepth, depth);
+        }
+        m_values.resize(m_maxDepth);
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbBreakpointExpression::Evaluate(wabt::interp::Environment *env,
+                                                   const wabt::interp::Thread *thread, int64_t *value) const {
+        if(m_code.empty()) {
+            return wabt::Result::Error;
+        }
+        int64_t *values = m_values.data();
+        size_t top = 0;
+        for(size_t i = 0; i < m_code.size(); i++) {
+            const Op &op = m_code[i];
+            switch (op.code) {
+                case OP_CONST:
+                    values[top++] = op.operand;
+                    break;
+                case OP_STACK32:
+                case OP_STACK64: {
+                    if(static_cast<uint64_t>(op.operand) > thread->NumValues()) {
+                        return wabt::Result::Error;
+                    }
+                    wabt::interp::Value slot = thread->ValueAt(thread->NumValues() - static_cast<wabt::Index>(op.operand));
+                    values[top++] = op.code == OP_STACK32 ? static_cast<int32_t>(slot.i32)
+                                                          : static_cast<int64_t>(slot.i64);
+                    break;
+                }
+                case OP_GLOBAL: {
+                    if(static_cast<uint64_t>(op.operand) >= env->GetGlobalCount()) {
+                        return wabt::Result::Error;
+                    }
+                    const wabt::interp::TypedValue &global =
+                            env->GetGlobal(static_cast<wabt::Index>(op.operand))->typed_value;
+                    switch (global.type) {
+                        case wabt::Type::I32:
+                            values[top++] = static_cast<int32_t>(global.value.i32);
+                            break;
+                        case wabt::Type::F32:
+                            values[top++] = global.value.f32_bits;
+                            break;
+                        case wabt::Type::I64:
+                            values[top++] = static_cast<int64_t>(global.value.i64);
+                            break;
+                        case wabt::Type::F64:
+                            values[top++] = static_cast<int64_t>(global.value.f64_bits);
+                            break;
+                        default:
+                            return wabt::Result::Error;
+                    }
+                    break;
+                }
+                case OP_LOAD_I8:
+                case OP_LOAD_U8:
+                case OP_LOAD_I16:
+                case OP_LOAD_U16:
+                case OP_LOAD_I32:
+                case OP_LOAD_U32:
+                case OP_LOAD_I64: {
+                    static const size_t sizes[] = {1, 1, 2, 2, 4, 4, 8};
+                    size_t size = sizes[op.code - OP_LOAD_I8];
+                    if(env->GetMemoryCount() == 0) {
+                        return wabt::Result::Error;
+                    }
+                    const std::vector<char> &data = env->GetMemory(0)->data;
+                    uint64_t address = static_cast<uint64_t>(values[top - 1]);
+                    if(data.size() < size || address > data.size() - size) {
+                        return wabt::Result::Error;
+                    }
+                    uint64_t bits = 0;
+                    memcpy(&bits, data.data() + address, size);
+                    switch (op.code) {
+                        case OP_LOAD_I8:
+                            values[top - 1] = static_cast<int8_t>(bits);
+                            break;
+                        case OP_LOAD_I16:
+                            values[top - 1] = static_cast<int16_t>(bits);
+                            break;
+                        case OP_LOAD_I32:
+                            values[top - 1] = static_cast<int32_t>(bits);
+                            break;
+                        default:
+                            values[top - 1] = static_cast<int64_t>(bits);
+                            break;
+                    }
+                    break;
+                }
+                case OP_NEG:
+                    values[top - 1] = static_cast<int64_t>(0 - static_cast<uint64_t>(values[top - 1]));
+                    break;
+                case OP_NOT:
+                    values[top - 1] = values[top - 1] == 0;
+                    break;
+                case OP_BIT_NOT:
+                    values[top - 1] = ~values[top - 1];
+                    break;
+                case OP_BOOL:
+                    values[top - 1] = values[top - 1] != 0;
+                    break;
+                case OP_AND_THEN:
+                case OP_OR_ELSE:
+                    if((values[top - 1] != 0) == (op.code == OP_OR_ELSE)) {
+                        values[top - 1] = values[top - 1] != 0;
+                        // The loop moves to the target
+                        i = static_cast<size_t>(op.operand) - 1;
+                    } else {
+                        top--;
+                    }
+                    break;
+                default: {
+                    int64_t right = values[--top];
+                    int64_t &left = values[top - 1];
+                    // Wrap around like the interpreter instead of overflowing
+                    uint64_t a = static_cast<uint64_t>(left);
+                    uint64_t b = static_cast<uint64_t>(right);
+                    switch (op.code) {
+                        case OP_MUL:
+                            left = static_cast<int64_t>(a * b);
+                            break;
+                        case OP_DIV:
+                        case OP_REM:
+                            if(right == 0) {
+                                return wabt::Result::Error;
+                            }
+                            if(right == -1) {
+                                left = op.code == OP_DIV ? static_cast<int64_t>(0 - a) : 0;
+                            } else {
+                                left = op.code == OP_DIV ? left / right : left % right;
+                            }
+                            break;
+                        case OP_ADD:
+                            left = static_cast<int64_t>(a + b);
+                            break;
+                        case OP_SUB:
+                            left = static_cast<int64_t>(a - b);
+                            break;
+                        case OP_SHL:
+                            left = static_cast<int64_t>(a << (b & 63));
+                            break;
+                        case OP_SHR:
+                            left = left >> (b & 63);
+                            break;
+                        case OP_LT:
+                            left = left < right;
+                            break;
+                        case OP_LE:
+                            left = left <= right;
+                            break;
+                        case OP_GT:
+                            left = left > right;
+                            break;
+                        case OP_GE:
+                            left = left >= right;
+                            break;
+                        case OP_EQ:
+                            left = left == right;
+                            break;
+                        case OP_NE:
+                            left = left != right;
+                            break;
+                        case OP_AND:
+                            left = left & right;
+                            break;
+                        case OP_XOR:
+                            left = left ^ right;
+                            break;
+                        case OP_OR:
+                            left = left | right;
+                            break;
+                        default:
+                            return wabt::Result::Error;
+                    }
+                    break;
+                }
+            }
+        }
+        *value = values[0];
+        return wabt::Result::Ok;
+    }
+}
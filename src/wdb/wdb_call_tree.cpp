@@ -0,0 +1,50 @@
+#include <wdb/wdb_call_tree.h>
+#include <algorithm>
+#include <sstream>
+
+namespace wdb {
+    uint32_t WdbCallTree::GetChild(uint32_t parent, wabt::Index function) {
+        uint64_t key = (static_cast<uint64_t>(parent) << 32) | function;
+        auto it = m_nodeIndex.find(key);
+        if(it != m_nodeIndex.end()) {
+            return it->second;
+        }
+        uint32_t node = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.push_back({parent, function, 0});
+        m_nodeIndex[key] = node;
+        return node;
+    }
+
+    std::string WdbCallTree::GetFoldedStacks(std::function<std::string(wabt::Index)> getName, double scale) const {
+        // Frame names cannot contain separators
+        std::unordered_map<wabt::Index, std::string> names;
+        auto getFrameName = [&](wabt::Index function) -> const std::string& {
+            auto it = names.find(function);
+            if(it == names.end()) {
+                std::string name = getName(function);
+                std::replace_if(name.begin(), name.end(), [](char c) {
+                    return c == ';' || c == ' ' || c == '\n';
+                }, '_');
+                it = names.emplace(function, name).first;
+            }
+            return it->second;
+        };
+        std::stringstream stream;
+        std::vector<uint32_t> path;
+        for(uint32_t i = 0; i < m_nodes.size(); i++) {
+            long value = (long) (m_nodes[i].value * scale);
+            if(value == 0) {
+                continue;
+            }
+            path.clear();
+            for(uint32_t node = i; node != kNoNode; node = m_nodes[node].parent) {
+                path.emplace_back(node);
+            }
+            for(auto it = path.rbegin(); it != path.rend(); it++) {
+                stream << (it == path.rbegin() ? "" : ";") << getFrameName(m_nodes[*it].function);
+            }
+            stream << " " << value << "\n";
+        }
+        return stream.str();
+    }
+}
@@ -9,12 +9,16 @@
 
 namespace wdb {
     wabt::Result WdbCodeGen::SetupCode(std::vector<uint8_t> *fileData) {
+        return SetupCode(fileData->data(), fileData->size());
+    }
+
+    wabt::Result WdbCodeGen::SetupCode(const uint8_t *data, size_t size) {
         // Prepare result value
         wabt::Result result;
         // Read binary and populate main module
         wabt::ReadBinaryOptions binaryOptions;
         wabt::Errors errors;
-        result = wabt::ReadBinaryIr("", fileData->data(), fileData->size(),
+        result = wabt::ReadBinaryIr("", data, size,
                 binaryOptions, &errors, &m_mainModule);
         if(result == wabt::Result::Ok) {
             // Validate main module
@@ -1,16 +1,25 @@
 #include <wdb/wdb_debugger_executor.h>
-#include <wabt/src/interp/interp-internal.h>
-#include <wabt/src/cast.h>
-#include <iomanip>
-#include <inttypes.h>
+#include <climits>
+#include <algorithm>
 
 namespace wdb {
+    namespace {
+        // Batch size while reversible, bounds the steps needed to locate a trap
+        const int kReverseBatchInstructions = 10000;
+        // Instructions between the first checkpoints, the spacing doubles each time their number is halved
+        const uint64_t kCheckpointInstructions = 1000000;
+        const size_t kMaxCheckpoints = 32;
+        // Granularity of the watched page bitmap, accesses to other pages skip the watchpoint list
+        const uint64_t kWatchPageSize = 4096;
+    }
+
     WdbDebuggerExecutor::WdbDebuggerExecutor(wdb::WdbExecutor::Options options) : WdbExecutor(std::move(options)) {}
 
     wabt::Result WdbDebuggerExecutor::ExecuteNextInstruction() {
         if(CanRun()) {
+            m_watchHit = false;
             // Run one instruction only
-            auto result = m_thread->Run(1);
+            auto result = EndRun(RunAndCheckpoint(1));
             // Main function has returned
             if(result == wabt::interp::Result::Returned) {
                 SetMainFunctionReturned();
@@ -25,19 +34,39 @@ namespace wdb {
     }
 
     wabt::Result WdbDebuggerExecutor::Execute() {
-        if (CanRun()) {
-            wabt::interp::Result result = wabt::interp::Result::Ok;
-            // Keep executing instructions
-            while (result == wabt::interp::Result::Ok) {
-                result = m_thread->Run(1);
-
-                // Check for breakpoints
-                const uint8_t *istream = m_env->istream().data.data();
-                const uint8_t *pc = &istream[m_thread->pc()];
-                if(m_breakPc.find(pc - istream) != m_breakPc.end()) {
-                    break;
+        // Watched accesses are only found through the break map
+        if (CanRun() && (m_watchpoints.empty() || PrepareBreakMap())) {
+            m_watchHit = false;
+            // Run the current instruction first so that continuing from a breakpoint makes progress
+            wabt::interp::Result result = RunAndCheckpoint(1);
+            if(m_breakPc.empty() && m_watchpoints.empty()) {
+                // No breakpoint is armed
+                const int batch = m_reversible ? kReverseBatchInstructions : INT_MAX;
+                while (result == wabt::interp::Result::Ok) {
+                    result = RunAndCheckpoint(batch);
+                }
+            } else if(PrepareBreakMap()) {
+                // Run in batches that cannot go past an armed breakpoint or watched access,
+                // run over the ones not hit, a host function writing watched memory stops after its call
+                while (result == wabt::interp::Result::Ok && !m_watchHit) {
+                    wabt::interp::IstreamOffset pc = m_thread->pc();
+                    if(m_breakMap.IsStop(pc)) {
+                        if(ShouldBreak(pc) || IsWatchHit(*m_breakMap.GetInstruction(pc))) {
+                            break;
+                        }
+                        result = RunAndCheckpoint(1);
+                    } else {
+                        int length = m_breakMap.GetRunLength(pc);
+                        result = RunAndCheckpoint(m_reversible ? std::min(length, kReverseBatchInstructions) : length);
+                    }
+                }
+            } else {
+                // Istream could not be decoded and no watchpoint is set, check breakpoints after every instruction
+                while (result == wabt::interp::Result::Ok && !ShouldBreak(m_thread->pc())) {
+                    result = RunAndCheckpoint(1);
                 }
             }
+            EndRun(result);
             // Main function has returned
             if (result == wabt::interp::Result::Returned) {
                 SetMainFunctionReturned();
@@ -51,613 +80,580 @@ namespace wdb {
         return wabt::Result::Error;
     }
 
-    void WdbDebuggerExecutor::AddBreakpoint(wabt::interp::IstreamOffset offset) {
-        m_breakPc.insert(offset);
+    wabt::Result WdbDebuggerExecutor::StepOver() {
+        if(!CanRun() || !PrepareStepMap()) {
+            return wabt::Result::Error;
+        }
+        const WdbInstructionDecoder::Instruction *instruction = m_stepMap.GetInstruction(m_thread->pc());
+        if(!instruction || (instruction->flow != WdbInstructionDecoder::FLOW_CALL
+                            && instruction->flow != WdbInstructionDecoder::FLOW_CALL_INDIRECT)) {
+            return ExecuteNextInstruction();
+        }
+        // Enter the call, then run the callee until it returns
+        const bool hostCall = IsHostCall(*instruction);
+        if(EndRun(RunAndCheckpoint(1)) != wabt::interp::Result::Ok) {
+            return wabt::Result::Error;
+        }
+        if(GetDepthChange(*instruction, hostCall) == 0) {
+            return wabt::Result::Ok;
+        }
+        return RunUntilReturn(false);
     }
 
-    void WdbDebuggerExecutor::RemoveBreakpoint(wabt::interp::IstreamOffset offset) {
-        for(auto i = m_breakPc.begin(); i != m_breakPc.end(); i++) {
-            if(*i == offset) {
-                m_breakPc.erase(i);
+    wabt::Result WdbDebuggerExecutor::StepOut() {
+        return RunUntilReturn(false);
+    }
+
+    wabt::Result WdbDebuggerExecutor::RunToReturn() {
+        return RunUntilReturn(true);
+    }
+
+    wabt::Result WdbDebuggerExecutor::RunUntilReturn(bool beforeReturn) {
+        if(!CanRun() || !PrepareStepMap()) {
+            return wabt::Result::Error;
+        }
+        m_watchHit = false;
+        wabt::interp::Result result = wabt::interp::Result::Ok;
+        int depth = 0;
+        bool moved = false;
+        while(result == wabt::interp::Result::Ok && depth >= 0 && !m_watchHit) {
+            wabt::interp::IstreamOffset pc = m_thread->pc();
+            if(moved && m_breakPc.find(pc) != m_breakPc.end() && ShouldBreak(pc)) {
                 break;
             }
+            if(!m_stepMap.IsStop(pc)) {
+                // Run in batches that cannot go past a call, return, breakpoint or watched access
+                int length = m_stepMap.GetRunLength(pc);
+                result = RunAndCheckpoint(m_reversible ? std::min(length, kReverseBatchInstructions) : length);
+            } else {
+                const WdbInstructionDecoder::Instruction *instruction = m_stepMap.GetInstruction(pc);
+                if(moved && IsWatchHit(*instruction)) {
+                    break;
+                }
+                // The callee of an indirect call is only known before running it
+                const bool hostCall = IsHostCall(*instruction);
+                if(beforeReturn && depth == 0 && GetDepthChange(*instruction, hostCall) < 0) {
+                    break;
+                }
+                result = RunAndCheckpoint(1);
+                if(result == wabt::interp::Result::Ok) {
+                    depth += GetDepthChange(*instruction, hostCall);
+                }
+            }
+            moved = true;
+        }
+        EndRun(result);
+        // Main function has returned
+        if(result == wabt::interp::Result::Returned) {
+            SetMainFunctionReturned();
+            return wabt::Result::Ok;
         }
+        return result == wabt::interp::Result::Ok ? wabt::Result::Ok : wabt::Result::Error;
     }
 
-    wabt::interp::IstreamOffset WdbDebuggerExecutor::GetPcOffset() {
-        const uint8_t *istream = m_env->istream().data.data();
-        const uint8_t *pc = &istream[m_thread->pc()];
-        return static_cast<wabt::interp::IstreamOffset>(pc - istream);
+    int WdbDebuggerExecutor::GetDepthChange(const WdbInstructionDecoder::Instruction &instruction,
+                                            bool hostCall) const {
+        switch (instruction.flow) {
+            case WdbInstructionDecoder::FLOW_CALL:
+                return 1;
+            case WdbInstructionDecoder::FLOW_CALL_INDIRECT:
+                // A host function is called without entering a frame
+                return hostCall ? 0 : 1;
+            case WdbInstructionDecoder::FLOW_RETURN_CALL_INDIRECT:
+                // A host function returns in place of the current function
+                return hostCall ? -1 : 0;
+            case WdbInstructionDecoder::FLOW_RETURN:
+                return -1;
+            default:
+                // Tail calls replace the frame
+                return 0;
+        }
     }
 
-    std::vector<WdbDebuggerExecutor::Instruction> WdbDebuggerExecutor::DisassembleModule(
-            wabt::interp::DefinedModule *module) {
-        using namespace wabt;
-        using namespace wabt::interp;
-        std::vector<Instruction> result;
-        auto from = module->istream_start;
-        auto to = module->istream_end;
-        if (from < m_env->istream().data.size()) {
-            to = std::min<wabt::interp::IstreamOffset>(to, m_env->istream().data.size());
-            const uint8_t *istream = m_env->istream().data.data();
-            const uint8_t *pc = &istream[from];
-
-            wabt::interp::IstreamOffset offset;
-            while ((offset = static_cast<wabt::interp::IstreamOffset>(pc - istream)) < to) {
-                result.emplace_back(Instruction());
-                MemoryStream stream;
-                Opcode opcode = ReadOpcode(&pc);
-                assert(!opcode.IsInvalid());
-                switch (opcode) {
-                    case Opcode::Select:
-                    case Opcode::V128BitSelect:
-                        stream.Writef("%s %%[-3], %%[-2], %%[-1]", opcode.GetName());
-                        break;
-
-                    case Opcode::Br:
-                        stream.Writef("%s @%u", opcode.GetName(), ReadU32(&pc));
-                        break;
-
-                    case Opcode::BrIf:
-                        stream.Writef("%s @%u, %%[-1]", opcode.GetName(), ReadU32(&pc));
-                        break;
-
-                    case Opcode::BrTable: {
-                        const Index num_targets = ReadU32(&pc);
-                        const IstreamOffset table_offset = ReadU32(&pc);
-                        stream.Writef("%s %%[-1], $#%" PRIindex ", table:$%u",
-                                      opcode.GetName(), num_targets, table_offset);
-                        break;
-                    }
-
-                    case Opcode::Nop:
-                    case Opcode::Return:
-                    case Opcode::Unreachable:
-                    case Opcode::Drop:
-                        stream.Writef("%s", opcode.GetName());
-                        break;
-
-                    case Opcode::MemorySize: {
-                        const Index memory_index = ReadU32(&pc);
-                        stream.Writef("%s $%" PRIindex "", opcode.GetName(), memory_index);
-                        break;
-                    }
+    wabt::Result WdbDebuggerExecutor::EnableReverseExecution(bool trackDirtyPages) {
+        // Tracked before the first checkpoint so that every checkpoint is found from the writes
+        if(trackDirtyPages && !wabt::Succeeded(TrackDirtyPages())) {
+            return wabt::Result::Error;
+        }
+        WdbSnapshot snapshot;
+        if(!wabt::Succeeded(Snapshot(&snapshot))) {
+            return wabt::Result::Error;
+        }
+        m_checkpoints.clear();
+        m_checkpoints.emplace_back();
+        m_checkpoints.back().snapshot = std::move(snapshot);
+        m_checkpointInterval = kCheckpointInstructions;
+        // Later checkpoints can be taken inside calls, without it only the first one exists
+        TrackCallFrames();
+        // Host functions are not called again when re-executing
+        KeepHostCallHistory(true);
+        m_reversible = true;
+        m_ended = false;
+        AddCheckpointHits(&m_checkpoints.back());
+        return wabt::Result::Ok;
+    }
 
-                    case Opcode::I32Const:
-                        stream.Writef("%s %u", opcode.GetName(), ReadU32(&pc));
-                        break;
-
-                    case Opcode::I64Const:
-                        stream.Writef("%s %" PRIu64 "", opcode.GetName(), ReadU64(&pc));
-                        break;
-
-                    case Opcode::F32Const:
-                        stream.Writef("%s %g", opcode.GetName(),
-                                      Bitcast<float>(ReadU32(&pc)));
-                        break;
-
-                    case Opcode::F64Const:
-                        stream.Writef("%s %g", opcode.GetName(),
-                                      Bitcast<double>(ReadU64(&pc)));
-                        break;
-
-                    case Opcode::LocalGet:
-                    case Opcode::GlobalGet:
-                        stream.Writef("%s $%u", opcode.GetName(), ReadU32(&pc));
-                        break;
-
-                    case Opcode::LocalSet:
-                    case Opcode::GlobalSet:
-                    case Opcode::LocalTee:
-                        stream.Writef("%s $%u, %%[-1]", opcode.GetName(), ReadU32(&pc));
-                        break;
-
-                    case Opcode::Call:
-                    case Opcode::ReturnCall:
-                        stream.Writef("%s @%u", opcode.GetName(), ReadU32(&pc));
-                        break;
-
-                    case Opcode::CallIndirect:
-                    case Opcode::ReturnCallIndirect: {
-                        const Index table_index = ReadU32(&pc);
-                        stream.Writef("%s $%" PRIindex ":%u, %%[-1]", opcode.GetName(),
-                                      table_index, ReadU32(&pc));
-                        break;
-                    }
+    wabt::Result WdbDebuggerExecutor::StepBack() {
+        uint64_t position;
+        if(!m_reversible || !wabt::Succeeded(GetPosition(&position))) {
+            return wabt::Result::Error;
+        }
+        // The last instruction of an ended run was not counted
+        if(m_ended) {
+            return RunToPosition(position);
+        }
+        if(position <= m_checkpoints.front().snapshot.instructionCount) {
+            return wabt::Result::Error;
+        }
+        return RunToPosition(position - 1);
+    }
 
-                    case Opcode::InterpCallHost:
-                        stream.Writef("%s $%u", opcode.GetName(), ReadU32(&pc));
-                        break;
-
-                    case Opcode::I32AtomicLoad:
-                    case Opcode::I64AtomicLoad:
-                    case Opcode::I32AtomicLoad8U:
-                    case Opcode::I32AtomicLoad16U:
-                    case Opcode::I64AtomicLoad8U:
-                    case Opcode::I64AtomicLoad16U:
-                    case Opcode::I64AtomicLoad32U:
-                    case Opcode::I32Load8S:
-                    case Opcode::I32Load8U:
-                    case Opcode::I32Load16S:
-                    case Opcode::I32Load16U:
-                    case Opcode::I64Load8S:
-                    case Opcode::I64Load8U:
-                    case Opcode::I64Load16S:
-                    case Opcode::I64Load16U:
-                    case Opcode::I64Load32S:
-                    case Opcode::I64Load32U:
-                    case Opcode::I32Load:
-                    case Opcode::I64Load:
-                    case Opcode::F32Load:
-                    case Opcode::F64Load:
-                    case Opcode::V128Load: {
-                        const Index memory_index = ReadU32(&pc);
-                        stream.Writef("%s $%" PRIindex ":%%[-1]+$%u", opcode.GetName(),
-                                      memory_index, ReadU32(&pc));
-                        break;
-                    }
+    wabt::Result WdbDebuggerExecutor::ReverseContinue() {
+        uint64_t position;
+        if(!m_reversible || !wabt::Succeeded(GetPosition(&position))) {
+            return wabt::Result::Error;
+        }
+        // Re-execute the checkpoint intervals from the latest one and remember the last breakpoint stop
+        // before the current position, tracepoints and ignored hits do not stop
+        uint64_t end = position;
+        for(size_t i = m_checkpoints.size(); i-- > 0 && !m_breakpoints.empty();) {
+            uint64_t start = m_checkpoints[i].snapshot.instructionCount;
+            if(start >= end) {
+                continue;
+            }
+            if(!wabt::Succeeded(RestoreCheckpoint(start))) {
+                return wabt::Result::Error;
+            }
+            uint64_t target = end;
+            SetOutputMuted(true);
+            wabt::interp::Result result = Replay(end, &target);
+            SetOutputMuted(false);
+            if(EndRun(result) != wabt::interp::Result::Ok) {
+                return wabt::Result::Error;
+            }
+            if(target != end) {
+                return RunToPosition(target);
+            }
+            end = start;
+        }
+        return RunToPosition(m_checkpoints.front().snapshot.instructionCount);
+    }
 
-                    case Opcode::AtomicNotify:
-                    case Opcode::I32AtomicStore:
-                    case Opcode::I64AtomicStore:
-                    case Opcode::I32AtomicStore8:
-                    case Opcode::I32AtomicStore16:
-                    case Opcode::I64AtomicStore8:
-                    case Opcode::I64AtomicStore16:
-                    case Opcode::I64AtomicStore32:
-                    case Opcode::I32AtomicRmwAdd:
-                    case Opcode::I64AtomicRmwAdd:
-                    case Opcode::I32AtomicRmw8AddU:
-                    case Opcode::I32AtomicRmw16AddU:
-                    case Opcode::I64AtomicRmw8AddU:
-                    case Opcode::I64AtomicRmw16AddU:
-                    case Opcode::I64AtomicRmw32AddU:
-                    case Opcode::I32AtomicRmwSub:
-                    case Opcode::I64AtomicRmwSub:
-                    case Opcode::I32AtomicRmw8SubU:
-                    case Opcode::I32AtomicRmw16SubU:
-                    case Opcode::I64AtomicRmw8SubU:
-                    case Opcode::I64AtomicRmw16SubU:
-                    case Opcode::I64AtomicRmw32SubU:
-                    case Opcode::I32AtomicRmwAnd:
-                    case Opcode::I64AtomicRmwAnd:
-                    case Opcode::I32AtomicRmw8AndU:
-                    case Opcode::I32AtomicRmw16AndU:
-                    case Opcode::I64AtomicRmw8AndU:
-                    case Opcode::I64AtomicRmw16AndU:
-                    case Opcode::I64AtomicRmw32AndU:
-                    case Opcode::I32AtomicRmwOr:
-                    case Opcode::I64AtomicRmwOr:
-                    case Opcode::I32AtomicRmw8OrU:
-                    case Opcode::I32AtomicRmw16OrU:
-                    case Opcode::I64AtomicRmw8OrU:
-                    case Opcode::I64AtomicRmw16OrU:
-                    case Opcode::I64AtomicRmw32OrU:
-                    case Opcode::I32AtomicRmwXor:
-                    case Opcode::I64AtomicRmwXor:
-                    case Opcode::I32AtomicRmw8XorU:
-                    case Opcode::I32AtomicRmw16XorU:
-                    case Opcode::I64AtomicRmw8XorU:
-                    case Opcode::I64AtomicRmw16XorU:
-                    case Opcode::I64AtomicRmw32XorU:
-                    case Opcode::I32AtomicRmwXchg:
-                    case Opcode::I64AtomicRmwXchg:
-                    case Opcode::I32AtomicRmw8XchgU:
-                    case Opcode::I32AtomicRmw16XchgU:
-                    case Opcode::I64AtomicRmw8XchgU:
-                    case Opcode::I64AtomicRmw16XchgU:
-                    case Opcode::I64AtomicRmw32XchgU:
-                    case Opcode::I32Store8:
-                    case Opcode::I32Store16:
-                    case Opcode::I32Store:
-                    case Opcode::I64Store8:
-                    case Opcode::I64Store16:
-                    case Opcode::I64Store32:
-                    case Opcode::I64Store:
-                    case Opcode::F32Store:
-                    case Opcode::F64Store:
-                    case Opcode::V128Store: {
-                        const Index memory_index = ReadU32(&pc);
-                        stream.Writef("%s $%" PRIindex ":%%[-2]+$%u, %%[-1]",
-                                      opcode.GetName(), memory_index, ReadU32(&pc));
-                        break;
-                    }
+    wabt::interp::Result WdbDebuggerExecutor::RunAndCheckpoint(int count) {
+        wabt::interp::Result result = RunInstructions(count);
+        if(m_reversible && result == wabt::interp::Result::Ok
+           && GetInstructionCount() >= m_checkpoints.back().snapshot.instructionCount + m_checkpointInterval) {
+            AddCheckpoint();
+        }
+        return result;
+    }
 
-                    case Opcode::I32AtomicWait:
-                    case Opcode::I64AtomicWait:
-                    case Opcode::I32AtomicRmwCmpxchg:
-                    case Opcode::I64AtomicRmwCmpxchg:
-                    case Opcode::I32AtomicRmw8CmpxchgU:
-                    case Opcode::I32AtomicRmw16CmpxchgU:
-                    case Opcode::I64AtomicRmw8CmpxchgU:
-                    case Opcode::I64AtomicRmw16CmpxchgU:
-                    case Opcode::I64AtomicRmw32CmpxchgU: {
-                        const Index memory_index = ReadU32(&pc);
-                        stream.Writef("%s $%" PRIindex ":%%[-3]+$%u, %%[-2], %%[-1]",
-                                      opcode.GetName(), memory_index, ReadU32(&pc));
-                        break;
-                    }
+    void WdbDebuggerExecutor::AddCheckpoint() {
+        // No checkpoint is taken on a suspended host call or inside calls that are not followed
+        WdbSnapshot snapshot;
+        if(!wabt::Succeeded(Snapshot(&snapshot))) {
+            return;
+        }
+        m_checkpoints.emplace_back();
+        m_checkpoints.back().snapshot = std::move(snapshot);
+        AddCheckpointHits(&m_checkpoints.back());
+        // Keep the first checkpoint and every other one after it
+        if(m_checkpoints.size() > kMaxCheckpoints) {
+            size_t kept = 1;
+            for(size_t i = 2; i < m_checkpoints.size(); i += 2) {
+                m_checkpoints[kept++] = std::move(m_checkpoints[i]);
+            }
+            m_checkpoints.resize(kept);
+            m_checkpointInterval *= 2;
+        }
+    }
 
-                    case Opcode::I32Add:
-                    case Opcode::I32Sub:
-                    case Opcode::I32Mul:
-                    case Opcode::I32DivS:
-                    case Opcode::I32DivU:
-                    case Opcode::I32RemS:
-                    case Opcode::I32RemU:
-                    case Opcode::I32And:
-                    case Opcode::I32Or:
-                    case Opcode::I32Xor:
-                    case Opcode::I32Shl:
-                    case Opcode::I32ShrU:
-                    case Opcode::I32ShrS:
-                    case Opcode::I32Eq:
-                    case Opcode::I32Ne:
-                    case Opcode::I32LtS:
-                    case Opcode::I32LeS:
-                    case Opcode::I32LtU:
-                    case Opcode::I32LeU:
-                    case Opcode::I32GtS:
-                    case Opcode::I32GeS:
-                    case Opcode::I32GtU:
-                    case Opcode::I32GeU:
-                    case Opcode::I32Rotr:
-                    case Opcode::I32Rotl:
-                    case Opcode::F32Add:
-                    case Opcode::F32Sub:
-                    case Opcode::F32Mul:
-                    case Opcode::F32Div:
-                    case Opcode::F32Min:
-                    case Opcode::F32Max:
-                    case Opcode::F32Copysign:
-                    case Opcode::F32Eq:
-                    case Opcode::F32Ne:
-                    case Opcode::F32Lt:
-                    case Opcode::F32Le:
-                    case Opcode::F32Gt:
-                    case Opcode::F32Ge:
-                    case Opcode::I64Add:
-                    case Opcode::I64Sub:
-                    case Opcode::I64Mul:
-                    case Opcode::I64DivS:
-                    case Opcode::I64DivU:
-                    case Opcode::I64RemS:
-                    case Opcode::I64RemU:
-                    case Opcode::I64And:
-                    case Opcode::I64Or:
-                    case Opcode::I64Xor:
-                    case Opcode::I64Shl:
-                    case Opcode::I64ShrU:
-                    case Opcode::I64ShrS:
-                    case Opcode::I64Eq:
-                    case Opcode::I64Ne:
-                    case Opcode::I64LtS:
-                    case Opcode::I64LeS:
-                    case Opcode::I64LtU:
-                    case Opcode::I64LeU:
-                    case Opcode::I64GtS:
-                    case Opcode::I64GeS:
-                    case Opcode::I64GtU:
-                    case Opcode::I64GeU:
-                    case Opcode::I64Rotr:
-                    case Opcode::I64Rotl:
-                    case Opcode::F64Add:
-                    case Opcode::F64Sub:
-                    case Opcode::F64Mul:
-                    case Opcode::F64Div:
-                    case Opcode::F64Min:
-                    case Opcode::F64Max:
-                    case Opcode::F64Copysign:
-                    case Opcode::F64Eq:
-                    case Opcode::F64Ne:
-                    case Opcode::F64Lt:
-                    case Opcode::F64Le:
-                    case Opcode::F64Gt:
-                    case Opcode::F64Ge:
-                    case Opcode::I8X16Add:
-                    case Opcode::I16X8Add:
-                    case Opcode::I32X4Add:
-                    case Opcode::I64X2Add:
-                    case Opcode::I8X16Sub:
-                    case Opcode::I16X8Sub:
-                    case Opcode::I32X4Sub:
-                    case Opcode::I64X2Sub:
-                    case Opcode::I8X16Mul:
-                    case Opcode::I16X8Mul:
-                    case Opcode::I32X4Mul:
-                    case Opcode::I8X16AddSaturateS:
-                    case Opcode::I8X16AddSaturateU:
-                    case Opcode::I16X8AddSaturateS:
-                    case Opcode::I16X8AddSaturateU:
-                    case Opcode::I8X16SubSaturateS:
-                    case Opcode::I8X16SubSaturateU:
-                    case Opcode::I16X8SubSaturateS:
-                    case Opcode::I16X8SubSaturateU:
-                    case Opcode::I8X16Shl:
-                    case Opcode::I16X8Shl:
-                    case Opcode::I32X4Shl:
-                    case Opcode::I64X2Shl:
-                    case Opcode::I8X16ShrS:
-                    case Opcode::I8X16ShrU:
-                    case Opcode::I16X8ShrS:
-                    case Opcode::I16X8ShrU:
-                    case Opcode::I32X4ShrS:
-                    case Opcode::I32X4ShrU:
-                    case Opcode::I64X2ShrS:
-                    case Opcode::I64X2ShrU:
-                    case Opcode::V128And:
-                    case Opcode::V128Or:
-                    case Opcode::V128Xor:
-                    case Opcode::I8X16Eq:
-                    case Opcode::I16X8Eq:
-                    case Opcode::I32X4Eq:
-                    case Opcode::F32X4Eq:
-                    case Opcode::F64X2Eq:
-                    case Opcode::I8X16Ne:
-                    case Opcode::I16X8Ne:
-                    case Opcode::I32X4Ne:
-                    case Opcode::F32X4Ne:
-                    case Opcode::F64X2Ne:
-                    case Opcode::I8X16LtS:
-                    case Opcode::I8X16LtU:
-                    case Opcode::I16X8LtS:
-                    case Opcode::I16X8LtU:
-                    case Opcode::I32X4LtS:
-                    case Opcode::I32X4LtU:
-                    case Opcode::F32X4Lt:
-                    case Opcode::F64X2Lt:
-                    case Opcode::I8X16LeS:
-                    case Opcode::I8X16LeU:
-                    case Opcode::I16X8LeS:
-                    case Opcode::I16X8LeU:
-                    case Opcode::I32X4LeS:
-                    case Opcode::I32X4LeU:
-                    case Opcode::F32X4Le:
-                    case Opcode::F64X2Le:
-                    case Opcode::I8X16GtS:
-                    case Opcode::I8X16GtU:
-                    case Opcode::I16X8GtS:
-                    case Opcode::I16X8GtU:
-                    case Opcode::I32X4GtS:
-                    case Opcode::I32X4GtU:
-                    case Opcode::F32X4Gt:
-                    case Opcode::F64X2Gt:
-                    case Opcode::I8X16GeS:
-                    case Opcode::I8X16GeU:
-                    case Opcode::I16X8GeS:
-                    case Opcode::I16X8GeU:
-                    case Opcode::I32X4GeS:
-                    case Opcode::I32X4GeU:
-                    case Opcode::F32X4Ge:
-                    case Opcode::F64X2Ge:
-                    case Opcode::F32X4Min:
-                    case Opcode::F64X2Min:
-                    case Opcode::F32X4Max:
-                    case Opcode::F64X2Max:
-                    case Opcode::F32X4Add:
-                    case Opcode::F64X2Add:
-                    case Opcode::F32X4Sub:
-                    case Opcode::F64X2Sub:
-                    case Opcode::F32X4Div:
-                    case Opcode::F64X2Div:
-                    case Opcode::F32X4Mul:
-                    case Opcode::F64X2Mul:
-                        stream.Writef("%s %%[-2], %%[-1]", opcode.GetName());
-                        break;
-
-                    case Opcode::I32Clz:
-                    case Opcode::I32Ctz:
-                    case Opcode::I32Popcnt:
-                    case Opcode::I32Eqz:
-                    case Opcode::I64Clz:
-                    case Opcode::I64Ctz:
-                    case Opcode::I64Popcnt:
-                    case Opcode::I64Eqz:
-                    case Opcode::F32Abs:
-                    case Opcode::F32Neg:
-                    case Opcode::F32Ceil:
-                    case Opcode::F32Floor:
-                    case Opcode::F32Trunc:
-                    case Opcode::F32Nearest:
-                    case Opcode::F32Sqrt:
-                    case Opcode::F64Abs:
-                    case Opcode::F64Neg:
-                    case Opcode::F64Ceil:
-                    case Opcode::F64Floor:
-                    case Opcode::F64Trunc:
-                    case Opcode::F64Nearest:
-                    case Opcode::F64Sqrt:
-                    case Opcode::I32TruncF32S:
-                    case Opcode::I32TruncF32U:
-                    case Opcode::I64TruncF32S:
-                    case Opcode::I64TruncF32U:
-                    case Opcode::F64PromoteF32:
-                    case Opcode::I32ReinterpretF32:
-                    case Opcode::I32TruncF64S:
-                    case Opcode::I32TruncF64U:
-                    case Opcode::I64TruncF64S:
-                    case Opcode::I64TruncF64U:
-                    case Opcode::F32DemoteF64:
-                    case Opcode::I64ReinterpretF64:
-                    case Opcode::I32WrapI64:
-                    case Opcode::F32ConvertI64S:
-                    case Opcode::F32ConvertI64U:
-                    case Opcode::F64ConvertI64S:
-                    case Opcode::F64ConvertI64U:
-                    case Opcode::F64ReinterpretI64:
-                    case Opcode::I64ExtendI32S:
-                    case Opcode::I64ExtendI32U:
-                    case Opcode::F32ConvertI32S:
-                    case Opcode::F32ConvertI32U:
-                    case Opcode::F32ReinterpretI32:
-                    case Opcode::F64ConvertI32S:
-                    case Opcode::F64ConvertI32U:
-                    case Opcode::I32TruncSatF32S:
-                    case Opcode::I32TruncSatF32U:
-                    case Opcode::I64TruncSatF32S:
-                    case Opcode::I64TruncSatF32U:
-                    case Opcode::I32TruncSatF64S:
-                    case Opcode::I32TruncSatF64U:
-                    case Opcode::I64TruncSatF64S:
-                    case Opcode::I64TruncSatF64U:
-                    case Opcode::I32Extend16S:
-                    case Opcode::I32Extend8S:
-                    case Opcode::I64Extend16S:
-                    case Opcode::I64Extend32S:
-                    case Opcode::I64Extend8S:
-                    case Opcode::I8X16Splat:
-                    case Opcode::I16X8Splat:
-                    case Opcode::I32X4Splat:
-                    case Opcode::I64X2Splat:
-                    case Opcode::F32X4Splat:
-                    case Opcode::F64X2Splat:
-                    case Opcode::I8X16Neg:
-                    case Opcode::I16X8Neg:
-                    case Opcode::I32X4Neg:
-                    case Opcode::I64X2Neg:
-                    case Opcode::V128Not:
-                    case Opcode::I8X16AnyTrue:
-                    case Opcode::I16X8AnyTrue:
-                    case Opcode::I32X4AnyTrue:
-                    case Opcode::I64X2AnyTrue:
-                    case Opcode::I8X16AllTrue:
-                    case Opcode::I16X8AllTrue:
-                    case Opcode::I32X4AllTrue:
-                    case Opcode::I64X2AllTrue:
-                    case Opcode::F32X4Neg:
-                    case Opcode::F64X2Neg:
-                    case Opcode::F32X4Abs:
-                    case Opcode::F64X2Abs:
-                    case Opcode::F32X4Sqrt:
-                    case Opcode::F64X2Sqrt:
-                    case Opcode::F32X4ConvertI32X4S:
-                    case Opcode::F32X4ConvertI32X4U:
-                    case Opcode::F64X2ConvertI64X2S:
-                    case Opcode::F64X2ConvertI64X2U:
-                    case Opcode::I32X4TruncSatF32X4S:
-                    case Opcode::I32X4TruncSatF32X4U:
-                    case Opcode::I64X2TruncSatF64X2S:
-                    case Opcode::I64X2TruncSatF64X2U:
-                        stream.Writef("%s %%[-1]", opcode.GetName());
-                        break;
-
-                    case Opcode::I8X16ExtractLaneS:
-                    case Opcode::I8X16ExtractLaneU:
-                    case Opcode::I16X8ExtractLaneS:
-                    case Opcode::I16X8ExtractLaneU:
-                    case Opcode::I32X4ExtractLane:
-                    case Opcode::I64X2ExtractLane:
-                    case Opcode::F32X4ExtractLane:
-                    case Opcode::F64X2ExtractLane: {
-                        stream.Writef("%s %%[-1] : (Lane imm: %d)", opcode.GetName(),
-                                      ReadU8(&pc));
-                        break;
-                    }
+    void WdbDebuggerExecutor::AddCheckpointHits(Checkpoint *checkpoint) {
+        checkpoint->hits.clear();
+        for(const auto &breakpoint : m_breakpoints) {
+            checkpoint->hits[breakpoint.first] = breakpoint.second.hits;
+        }
+    }
 
-                    case Opcode::I8X16ReplaceLane:
-                    case Opcode::I16X8ReplaceLane:
-                    case Opcode::I32X4ReplaceLane:
-                    case Opcode::I64X2ReplaceLane:
-                    case Opcode::F32X4ReplaceLane:
-                    case Opcode::F64X2ReplaceLane: {
-                        stream.Writef("%s %%[-1], %%[-2] : (Lane imm: %d)",
-                                      opcode.GetName(), ReadU8(&pc));
-                        break;
-                    }
+    wabt::Result WdbDebuggerExecutor::RestoreCheckpoint(uint64_t position) {
+        if(m_checkpoints.empty() || position < m_checkpoints.front().snapshot.instructionCount) {
+            return wabt::Result::Error;
+        }
+        // Later checkpoints are taken again when executing past them, as the execution may change from here
+        while(m_checkpoints.back().snapshot.instructionCount > position) {
+            m_checkpoints.pop_back();
+        }
+        const Checkpoint &checkpoint = m_checkpoints.back();
+        if(!wabt::Succeeded(Restore(checkpoint.snapshot))) {
+            return wabt::Result::Error;
+        }
+        // Hits of breakpoints added since count from the checkpoint
+        for(auto &breakpoint : m_breakpoints) {
+            auto hits = checkpoint.hits.find(breakpoint.first);
+            breakpoint.second.hits = hits != checkpoint.hits.end() ? hits->second : 0;
+        }
+        m_ended = false;
+        return wabt::Result::Ok;
+    }
 
-                    case Opcode::V8X16Shuffle:
-                        stream.Writef(
-                                "%s %%[-2], %%[-1] : (Lane imm: $0x%08x 0x%08x 0x%08x 0x%08x )",
-                                opcode.GetName(), ReadU32(&pc), ReadU32(&pc), ReadU32(&pc),
-                                ReadU32(&pc));
-                        break;
-
-                    case Opcode::MemoryGrow: {
-                        Index memory_index = ReadU32(&pc);
-                        stream.Writef("%s $%" PRIindex ":%%[-1]", opcode.GetName(),
-                                      memory_index);
-                        break;
+    wabt::interp::Result WdbDebuggerExecutor::Replay(uint64_t end, uint64_t *lastStop) {
+        const bool useMap = !m_breakpoints.empty() && PrepareBreakMap();
+        wabt::interp::Result result = wabt::interp::Result::Ok;
+        while(result == wabt::interp::Result::Ok && GetInstructionCount() < end) {
+            int count = (int) std::min<uint64_t>(end - GetInstructionCount(), kReverseBatchInstructions);
+            if(!m_breakpoints.empty()) {
+                // Stop at breakpoints to count their hits
+                wabt::interp::IstreamOffset pc = m_thread->pc();
+                if(!useMap || m_breakMap.IsStop(pc)) {
+                    if(CountHit(pc) && lastStop) {
+                        *lastStop = GetInstructionCount();
                     }
+                    count = 1;
+                } else {
+                    count = std::min(count, m_breakMap.GetRunLength(pc));
+                }
+            }
+            result = RunAndCheckpoint(count);
+        }
+        return result;
+    }
 
-                    case Opcode::InterpAlloca:
-                        stream.Writef("%s $%u", opcode.GetName(), ReadU32(&pc));
-                        break;
+    bool WdbDebuggerExecutor::CountHit(wabt::interp::IstreamOffset offset) {
+        auto it = m_breakpoints.find(offset);
+        if(it == m_breakpoints.end() || !IsConditionMet(it->second)) {
+            return false;
+        }
+        Breakpoint &breakpoint = it->second;
+        breakpoint.hits++;
+        return breakpoint.hits > breakpoint.ignoreCount && !breakpoint.tracepoint;
+    }
 
-                    case Opcode::InterpBrUnless:
-                        stream.Writef("%s @%u, %%[-1]", opcode.GetName(), ReadU32(&pc));
-                        break;
+    wabt::interp::Result WdbDebuggerExecutor::EndRun(wabt::interp::Result result) {
+        // Running out of fuel stops before a batch and a suspended host call leaves the pc on the call,
+        // the position stays exact
+        m_ended = result != wabt::interp::Result::Ok && GetRunLimit() != FUEL_LIMIT && !GetPendingCall();
+        return result;
+    }
 
-                    case Opcode::InterpDropKeep: {
-                        const uint32_t drop = ReadU32(&pc);
-                        const uint32_t keep = ReadU32(&pc);
-                        stream.Writef("%s $%u $%u", opcode.GetName(), drop, keep);
-                        break;
-                    }
+    wabt::Result WdbDebuggerExecutor::GetPosition(uint64_t *position) {
+        if(!m_ended) {
+            *position = GetInstructionCount();
+            return wabt::Result::Ok;
+        }
+        // Step from the start of the ended batch to find its last instruction
+        if(!wabt::Succeeded(RunToPosition(GetInstructionCount()))) {
+            return wabt::Result::Error;
+        }
+        SetOutputMuted(true);
+        wabt::interp::Result result;
+        while((result = RunInstructions(1)) == wabt::interp::Result::Ok) {
+            CountHit(m_thread->pc());
+        }
+        SetOutputMuted(false);
+        EndRun(result);
+        if(result == wabt::interp::Result::Returned) {
+            SetMainFunctionReturned();
+        }
+        *position = GetInstructionCount();
+        return wabt::Result::Ok;
+    }
 
-                    case Opcode::InterpData:
-                        stream.Writef("%s ...", opcode.GetName());
-                        break;
+    wabt::Result WdbDebuggerExecutor::RunToPosition(uint64_t position) {
+        if(!wabt::Succeeded(RestoreCheckpoint(position))) {
+            return wabt::Result::Error;
+        }
+        // Host calls return their kept results, output posted by the execution was already posted
+        SetOutputMuted(true);
+        wabt::interp::Result result = Replay(position, nullptr);
+        // Hits count up to the position, like when stopping there
+        if(result == wabt::interp::Result::Ok) {
+            CountHit(m_thread->pc());
+        }
+        SetOutputMuted(false);
+        return EndRun(result) == wabt::interp::Result::Ok ? wabt::Result::Ok : wabt::Result::Error;
+    }
 
-                    case Opcode::V128Const: {
-                        stream.Writef("%s 0x%08x 0x%08x 0x%08x 0x%08x", opcode.GetName(),
-                                      ReadU32(&pc), ReadU32(&pc), ReadU32(&pc), ReadU32(&pc));
-                        break;
-                    }
+    void WdbDebuggerExecutor::AddBreakpoint(wabt::interp::IstreamOffset offset) {
+        m_breakPc.insert(offset);
+        m_breakpoints[offset] = Breakpoint();
+        m_breakMapDirty = true;
+        m_stepMapDirty = true;
+    }
 
-                    case Opcode::MemoryInit:
-                        WABT_UNREACHABLE;
-                        break;
-
-                    case Opcode::MemoryDrop:
-                        WABT_UNREACHABLE;
-                        break;
-
-                    case Opcode::MemoryCopy:
-                        WABT_UNREACHABLE;
-                        break;
-
-                    case Opcode::MemoryFill:
-                        WABT_UNREACHABLE;
-                        break;
-
-                    case Opcode::TableInit:
-                        WABT_UNREACHABLE;
-                        break;
-
-                    case Opcode::TableDrop:
-                        WABT_UNREACHABLE;
-                        break;
-
-                    case Opcode::TableCopy:
-                        WABT_UNREACHABLE;
-                        break;
-
-                        // The following opcodes are either never generated or should never be
-                        // executed.
-                    case Opcode::Block:
-                    case Opcode::Catch:
-                    case Opcode::Else:
-                    case Opcode::End:
-                    case Opcode::If:
-                    case Opcode::IfExcept:
-                    case Opcode::Invalid:
-                    case Opcode::Loop:
-                    case Opcode::Rethrow:
-                    case Opcode::Throw:
-                    case Opcode::Try:
-                        WABT_UNREACHABLE;
-                        break;
-                    default:
-                        throw std::runtime_error("Disassembled code for " + std::string(opcode.GetName())
-                                                 + " no implemented");
-                        break;
+    wabt::Result WdbDebuggerExecutor::AddBreakpoint(wabt::interp::IstreamOffset offset,
+                                                    const BreakpointOptions &options, std::string *error) {
+        Breakpoint breakpoint;
+        if(!options.condition.empty() && !wabt::Succeeded(breakpoint.condition.Compile(options.condition, error))) {
+            return wabt::Result::Error;
+        }
+        breakpoint.ignoreCount = options.ignoreCount;
+        breakpoint.tracepoint = !options.logMessage.empty();
+        // Split the message into text and {expression} parts
+        const std::string &message = options.logMessage;
+        size_t start = 0;
+        for(size_t open; (open = message.find('{', start)) != std::string::npos;) {
+            size_t close = message.find('}', open);
+            if(close == std::string::npos) {
+                if(error) {
+                    *error = "missing '}' in log message";
                 }
-                // Update instruction object
-                result.back().istream_start = offset;
-                result.back().str = std::string(stream.output_buffer().data.begin(),
-                                                    stream.output_buffer().data.end());
+                return wabt::Result::Error;
+            }
+            breakpoint.logText.emplace_back(message.substr(start, open - start));
+            breakpoint.logValues.emplace_back();
+            if(!wabt::Succeeded(breakpoint.logValues.back().Compile(message.substr(open + 1, close - open - 1),
+                                                                    error))) {
+                return wabt::Result::Error;
             }
+            start = close + 1;
         }
-        return result;
+        breakpoint.logText.emplace_back(message.substr(start));
+        m_breakPc.insert(offset);
+        m_breakpoints[offset] = std::move(breakpoint);
+        m_breakMapDirty = true;
+        m_stepMapDirty = true;
+        return wabt::Result::Ok;
+    }
+
+    uint64_t WdbDebuggerExecutor::GetBreakpointHits(wabt::interp::IstreamOffset offset) const {
+        auto it = m_breakpoints.find(offset);
+        return it != m_breakpoints.end() ? it->second.hits : 0;
+    }
+
+    bool WdbDebuggerExecutor::IsConditionMet(const Breakpoint &breakpoint) {
+        if(breakpoint.condition.IsEmpty()) {
+            return true;
+        }
+        // A condition that cannot be evaluated stops so that it gets noticed
+        int64_t value;
+        return !wabt::Succeeded(breakpoint.condition.Evaluate(m_env, m_thread, &value)) || value != 0;
+    }
+
+    bool WdbDebuggerExecutor::ShouldBreak(wabt::interp::IstreamOffset offset) {
+        auto it = m_breakpoints.find(offset);
+        if(it == m_breakpoints.end()) {
+            return false;
+        }
+        Breakpoint &breakpoint = it->second;
+        if(!IsConditionMet(breakpoint)) {
+            return false;
+        }
+        breakpoint.hits++;
+        if(breakpoint.hits <= breakpoint.ignoreCount) {
+            return false;
+        }
+        if(!breakpoint.tracepoint) {
+            return true;
+        }
+        // Log and keep running
+        std::string message = breakpoint.logText[0];
+        for(size_t i = 0; i < breakpoint.logValues.size(); i++) {
+            int64_t value;
+            if(wabt::Succeeded(breakpoint.logValues[i].Evaluate(m_env, m_thread, &value))) {
+                message += std::to_string(value);
+            } else {
+                message += "<error>";
+            }
+            message += breakpoint.logText[i + 1];
+        }
+        if(m_traceHandler) {
+            m_traceHandler(offset, std::move(message));
+        } else {
+            PostOutput(message + "\n");
+        }
+        return false;
+    }
+
+    void WdbDebuggerExecutor::RemoveBreakpoint(wabt::interp::IstreamOffset offset) {
+        m_breakpoints.erase(offset);
+        if(m_breakPc.erase(offset)) {
+            m_breakMapDirty = true;
+            m_stepMapDirty = true;
+        }
+    }
+
+    wabt::Result WdbDebuggerExecutor::AddWatchpoint(wabt::Index memoryIndex, uint64_t offset, uint64_t size,
+                                                    WatchKind kind) {
+        // Watched accesses are found by decoding the istream
+        if(size == 0 || offset + size < offset || !m_env->GetMemory(memoryIndex) || !PrepareBreakMap()) {
+            return wabt::Result::Error;
+        }
+        Watchpoint watchpoint;
+        watchpoint.memoryIndex = memoryIndex;
+        watchpoint.offset = offset;
+        watchpoint.size = size;
+        watchpoint.kind = kind;
+        m_watchpoints.emplace_back(watchpoint);
+        UpdateWatchPages();
+        return wabt::Result::Ok;
+    }
+
+    void WdbDebuggerExecutor::RemoveWatchpoint(wabt::Index memoryIndex, uint64_t offset, uint64_t size) {
+        m_watchpoints.erase(std::remove_if(m_watchpoints.begin(), m_watchpoints.end(), [&](const Watchpoint &w) {
+            return w.memoryIndex == memoryIndex && w.offset == offset && w.size == size;
+        }), m_watchpoints.end());
+        UpdateWatchPages();
+    }
+
+    bool WdbDebuggerExecutor::GetWatchpointHit(Watchpoint *watchpoint, uint64_t *address) const {
+        if(!m_watchHit) {
+            return false;
+        }
+        *watchpoint = m_watchHitPoint;
+        *address = m_watchHitAddress;
+        return true;
+    }
+
+    void WdbDebuggerExecutor::UpdateWatchPages() {
+        // Memory instructions become stops when their memory gains its first watchpoint or loses its last
+        std::set<wabt::Index> watchedBefore;
+        for(auto &pair : m_watchPages) {
+            watchedBefore.insert(pair.first);
+        }
+        m_watchPages.clear();
+        for(const Watchpoint &watchpoint : m_watchpoints) {
+            std::vector<uint64_t> &pages = m_watchPages[watchpoint.memoryIndex];
+            uint64_t last = (watchpoint.offset + watchpoint.size - 1) / kWatchPageSize;
+            if(pages.size() <= last / 64) {
+                pages.resize(last / 64 + 1);
+            }
+            for(uint64_t page = watchpoint.offset / kWatchPageSize; page <= last; page++) {
+                pages[page / 64] |= uint64_t(1) << (page % 64);
+            }
+        }
+        std::set<wabt::Index> watchedAfter;
+        for(auto &pair : m_watchPages) {
+            watchedAfter.insert(pair.first);
+        }
+        if(watchedBefore != watchedAfter) {
+            m_breakMapDirty = true;
+            m_stepMapDirty = true;
+        }
+    }
+
+    bool WdbDebuggerExecutor::IsWatchedInstruction(const WdbInstructionDecoder::Instruction &instruction) const {
+        // Host functions may write watched memory through the executor
+        if(WdbInstructionDecoder::MayCallHost(instruction)) {
+            return !m_watchPages.empty();
+        }
+        WdbInstructionDecoder::MemoryAccess access;
+        return WdbInstructionDecoder::GetMemoryAccess(instruction, &access)
+               && m_watchPages.find(access.memoryIndex) != m_watchPages.end();
+    }
+
+    bool WdbDebuggerExecutor::IsWatchHit(const WdbInstructionDecoder::Instruction &instruction) {
+        WdbInstructionDecoder::MemoryAccess access;
+        const wabt::Index top = m_thread->NumValues();
+        if(!WdbInstructionDecoder::GetMemoryAccess(instruction, &access)
+           || top < std::max(access.addressSlot, access.sizeSlot)) {
+            return false;
+        }
+        // Effective address as computed by the interpreter, the operands are still on the stack
+        uint32_t base = m_thread->ValueAt(top - access.addressSlot).i32;
+        uint64_t address = static_cast<uint64_t>(base) + access.offset;
+        uint64_t size = access.sizeSlot != 0 ? m_thread->ValueAt(top - access.sizeSlot).i32 : access.size;
+        if(access.sourceSlot != 0) {
+            uint64_t source = m_thread->ValueAt(top - access.sourceSlot).i32;
+            return IsWatchedRange(access.memoryIndex, source, size, true, false)
+                   || IsWatchedRange(access.memoryIndex, address, size, false, true);
+        }
+        return IsWatchedRange(access.memoryIndex, address, size, access.reads, access.writes);
+    }
+
+    bool WdbDebuggerExecutor::IsWatchedRange(wabt::Index memoryIndex, uint64_t address, uint64_t size,
+                                             bool reads, bool writes) {
+        auto pages = m_watchPages.find(memoryIndex);
+        if(size == 0 || pages == m_watchPages.end()) {
+            return false;
+        }
+        // Check the page bitmap before the watchpoints
+        bool watched = false;
+        for(uint64_t page = address / kWatchPageSize; page <= (address + size - 1) / kWatchPageSize; page++) {
+            if(page / 64 >= pages->second.size()) {
+                break;
+            }
+            if((pages->second[page / 64] >> (page % 64)) & 1) {
+                watched = true;
+                break;
+            }
+        }
+        if(!watched) {
+            return false;
+        }
+        for(const Watchpoint &watchpoint : m_watchpoints) {
+            if(watchpoint.memoryIndex == memoryIndex
+               && address < watchpoint.offset + watchpoint.size && watchpoint.offset < address + size
+               && (((watchpoint.kind & WATCH_READ) && reads) || ((watchpoint.kind & WATCH_WRITE) && writes))) {
+                m_watchHit = true;
+                m_watchHitPoint = watchpoint;
+                m_watchHitAddress = std::max(address, watchpoint.offset);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WdbDebuggerExecutor::OnHostMemoryWrite(wabt::Index memoryIndex, uint64_t offset, uint64_t size) {
+        // The run stops once the host call returns
+        if(!m_watchHit) {
+            IsWatchedRange(memoryIndex, offset, size, false, true);
+        }
+    }
+
+    bool WdbDebuggerExecutor::PrepareBreakMap() {
+        // Rebuild the graph if the istream has changed
+        if(!m_breakMap.IsBuilt(m_env)) {
+            if(!wabt::Succeeded(m_breakMap.Build(m_env))) {
+                return false;
+            }
+            m_breakMapDirty = true;
+        }
+        // Recompute run lengths towards the armed breakpoints and watched memory accesses
+        if(m_breakMapDirty) {
+            m_breakMap.SetStops([&](const WdbInstructionDecoder::Instruction &instruction) {
+                return m_breakPc.find(instruction.offset) != m_breakPc.end() || IsWatchedInstruction(instruction);
+            });
+            m_breakMapDirty = false;
+        }
+        return true;
+    }
+
+    bool WdbDebuggerExecutor::PrepareStepMap() {
+        if(!m_stepMap.IsBuilt(m_env)) {
+            if(!wabt::Succeeded(m_stepMap.Build(m_env))) {
+                return false;
+            }
+            m_stepMapDirty = true;
+        }
+        if(m_stepMapDirty) {
+            m_stepMap.SetStops([&](const WdbInstructionDecoder::Instruction &instruction) {
+                return WdbInstructionDecoder::IsCallOrReturn(instruction)
+                       || m_breakPc.find(instruction.offset) != m_breakPc.end()
+                       || IsWatchedInstruction(instruction);
+            });
+            m_stepMapDirty = false;
+        }
+        return true;
+    }
+
+    wabt::interp::IstreamOffset WdbDebuggerExecutor::GetPcOffset() {
+        const uint8_t *istream = m_env->istream().data.data();
+        const uint8_t *pc = &istream[m_thread->pc()];
+        return static_cast<wabt::interp::IstreamOffset>(pc - istream);
+    }
+
+    WdbDisassemblyIndex* WdbDebuggerExecutor::GetDisassemblyIndex(wabt::interp::DefinedModule *module) {
+        auto it = m_disassemblyIndexes.find(module);
+        if(it == m_disassemblyIndexes.end() || !it->second.IsUpToDate()) {
+            m_disassemblyIndexes.erase(module);
+            it = m_disassemblyIndexes.emplace(module, WdbDisassemblyIndex(m_env, module)).first;
+        }
+        return &it->second;
+    }
+
+    std::vector<WdbDebuggerExecutor::Instruction> WdbDebuggerExecutor::DisassembleModule(
+            wabt::interp::DefinedModule *module) {
+        WdbDisassemblyIndex *index = GetDisassemblyIndex(module);
+        return index->Format(0, index->GetInstructionCount());
     }
 }
\ No newline at end of file
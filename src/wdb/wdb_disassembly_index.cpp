@@ -0,0 +1,86 @@
+#include <wdb/wdb_disassembly_index.h>
+#include <algorithm>
+
+namespace wdb {
+    WdbDisassemblyIndex::WdbDisassemblyIndex(wabt::interp::Environment *env, wabt::interp::DefinedModule *module)
+            : m_env(env), m_module(module), m_start(module->istream_start), m_end(module->istream_end),
+              m_decoded(module->istream_start) {
+        m_end = std::min<wabt::interp::IstreamOffset>(m_end, env->istream().data.size());
+    }
+
+    bool WdbDisassemblyIndex::IsUpToDate() const {
+        return m_module->istream_start == m_start && m_end <= m_module->istream_end
+               && m_end <= m_env->istream().data.size();
+    }
+
+    bool WdbDisassemblyIndex::DecodeNext() {
+        if(m_decoded >= m_end) {
+            return false;
+        }
+        const std::vector<uint8_t> &istream = m_env->istream().data;
+        WdbInstructionDecoder decoder(istream.data(), m_end);
+        WdbInstructionDecoder::Instruction instruction;
+        if(!wabt::Succeeded(decoder.Decode(m_decoded, &instruction))) {
+            // Stop indexing at undecodable bytes
+            m_end = m_decoded;
+            return false;
+        }
+        m_offsets.emplace_back(m_decoded);
+        m_decoded += instruction.length;
+        return true;
+    }
+
+    size_t WdbDisassemblyIndex::GetInstructionCount() {
+        while(DecodeNext()) {}
+        return m_offsets.size();
+    }
+
+    wabt::Result WdbDisassemblyIndex::GetOffset(size_t index, wabt::interp::IstreamOffset *offset) {
+        while(m_offsets.size() <= index && DecodeNext()) {}
+        if(index >= m_offsets.size()) {
+            return wabt::Result::Error;
+        }
+        *offset = m_offsets[index];
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbDisassemblyIndex::FindInstruction(wabt::interp::IstreamOffset offset, size_t *index) {
+        if(offset < m_start) {
+            return wabt::Result::Error;
+        }
+        while(m_decoded <= offset && DecodeNext()) {}
+        if(offset >= m_decoded) {
+            return wabt::Result::Error;
+        }
+        // Last instruction starting at or before the offset
+        auto it = std::upper_bound(m_offsets.begin(), m_offsets.end(), offset);
+        *index = static_cast<size_t>(it - m_offsets.begin()) - 1;
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbDisassemblyIndex::Decode(size_t index, WdbInstructionDecoder::Instruction *instruction) {
+        wabt::interp::IstreamOffset offset;
+        if(!wabt::Succeeded(GetOffset(index, &offset))) {
+            return wabt::Result::Error;
+        }
+        const std::vector<uint8_t> &istream = m_env->istream().data;
+        return WdbInstructionDecoder(istream.data(), m_end).Decode(offset, instruction);
+    }
+
+    std::vector<WdbDisassemblyIndex::Instruction> WdbDisassemblyIndex::Format(size_t first, size_t count) {
+        std::vector<Instruction> result;
+        while((m_offsets.size() <= first || m_offsets.size() - first < count) && DecodeNext()) {}
+        const std::vector<uint8_t> &istream = m_env->istream().data;
+        WdbInstructionDecoder decoder(istream.data(), m_end);
+        WdbInstructionDecoder::Instruction instruction;
+        for(size_t i = first; i < m_offsets.size() && i - first < count; i++) {
+            if(!wabt::Succeeded(decoder.Decode(m_offsets[i], &instruction))) {
+                break;
+            }
+            result.emplace_back(Instruction());
+            result.back().istream_start = m_offsets[i];
+            result.back().str = WdbInstructionDecoder::Format(instruction);
+        }
+        return result;
+    }
+}
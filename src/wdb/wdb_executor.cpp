@@ -1,15 +1,218 @@
 #include <wdb/wdb_executor.h>
 #include <wabt/src/binary-reader.h>
+#include <wabt/src/binary-reader-nop.h>
 #include <wabt/src/interp/binary-reader-interp.h>
 #include <wabt/src/cast.h>
+#include <wdb/wdb_timer.h>
 #include <utility>
 #include <iostream>
 #include <climits>
+#include <algorithm>
+#include <cstring>
 
 namespace wdb {
-    WdbExecutor::WdbExecutor(wdb::WdbExecutor::Options options) {
+    namespace {
+        // Collect the function names of the name section
+        class FunctionNameReader : public wabt::BinaryReaderNop {
+        public:
+            wabt::Result OnImportFunc(wabt::Index importIndex, wabt::string_view moduleName,
+                                      wabt::string_view fieldName, wabt::Index funcIndex,
+                                      wabt::Index sigIndex) override {
+                importedFunctions++;
+                return wabt::Result::Ok;
+            }
+
+            wabt::Result OnFunctionName(wabt::Index index, wabt::string_view name) override {
+                names[index] = std::string(name.begin(), name.end());
+                return wabt::Result::Ok;
+            }
+
+            wabt::Index importedFunctions = 0;
+            std::map<wabt::Index, std::string> names;
+        };
+
+        // Instructions run between two checks of the time limit and the cancellation token
+        const int kCheckInstructions = 10000;
+
+        // Memory writes are tracked, compared and restored in pages
+        const size_t kRestorePageSize = 4096;
+
+        // Environment image header, bump the version when the layout changes
+        const uint32_t kImageMagic = 0x49424457;
+        const uint32_t kImageVersion = 2;
+        // Lowering of the vendored interpreter, images hold its istream, bump when updating wabt
+        const uint32_t kIstreamFormat = 1;
+        const uint32_t kOpcodeCount = static_cast<uint32_t>(wabt::Opcode::Invalid) + 1;
+        // Memory is saved in chunks, chunks of zeros are skipped
+        const size_t kImageChunkSize = 4096;
+
+        // Append values to an environment image
+        class ImageWriter {
+        public:
+            explicit ImageWriter(std::vector<uint8_t>* out) : m_out(out) {}
+
+            template <typename T>
+            void Write(T value) {
+                WriteBytes(&value, sizeof(T));
+            }
+
+            void WriteBytes(const void* data, size_t size) {
+                auto bytes = static_cast<const uint8_t*>(data);
+                m_out->insert(m_out->end(), bytes, bytes + size);
+            }
+
+            void WriteString(const std::string& text) {
+                Write<uint32_t>(static_cast<uint32_t>(text.size()));
+                WriteBytes(text.data(), text.size());
+            }
+
+            void WriteTypes(const std::vector<wabt::Type>& types) {
+                Write<uint32_t>(static_cast<uint32_t>(types.size()));
+                for(wabt::Type type : types) {
+                    Write<int32_t>(static_cast<int32_t>(type));
+                }
+            }
+
+            void WriteLimits(const wabt::Limits& limits) {
+                Write<uint64_t>(limits.initial);
+                Write<uint64_t>(limits.max);
+                Write<uint8_t>(limits.has_max);
+                Write<uint8_t>(limits.is_shared);
+            }
+        private:
+            std::vector<uint8_t>* m_out;
+        };
+
+        // Read values from an environment image, reading past the end fails the reader
+        class ImageReader {
+        public:
+            ImageReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+            template <typename T>
+            T Read() {
+                T value = T();
+                const uint8_t* bytes = Skip(sizeof(T));
+                if(bytes) {
+                    memcpy(&value, bytes, sizeof(T));
+                }
+                return value;
+            }
+
+            const uint8_t* Skip(size_t size) {
+                if(!m_ok || size > m_size - m_offset) {
+                    m_ok = false;
+                    return nullptr;
+                }
+                const uint8_t* bytes = m_data + m_offset;
+                m_offset += size;
+                return bytes;
+            }
+
+            std::string ReadString() {
+                uint32_t size = Read<uint32_t>();
+                const uint8_t* bytes = Skip(size);
+                return bytes ? std::string(reinterpret_cast<const char*>(bytes), size) : std::string();
+            }
+
+            std::vector<wabt::Type> ReadTypes() {
+                std::vector<wabt::Type> types;
+                uint32_t count = Read<uint32_t>();
+                for(uint32_t i = 0; i < count && m_ok; i++) {
+                    types.emplace_back(static_cast<wabt::Type>(Read<int32_t>()));
+                }
+                return types;
+            }
+
+            wabt::Limits ReadLimits() {
+                wabt::Limits limits;
+                limits.initial = Read<uint64_t>();
+                limits.max = Read<uint64_t>();
+                limits.has_max = Read<uint8_t>() != 0;
+                limits.is_shared = Read<uint8_t>() != 0;
+                return limits;
+            }
+
+            bool Ok() const { return m_ok; }
+            bool AtEnd() const { return m_ok && m_offset == m_size; }
+        private:
+            const uint8_t* m_data;
+            size_t m_size;
+            size_t m_offset = 0;
+            bool m_ok = true;
+        };
+
+        /**
+         * Write the host modules, signatures and functions given before loading
+         * @param writer
+         * @param env
+         * @param prefix
+         */
+        void WriteHostPrefix(ImageWriter &writer, wabt::interp::Environment *env,
+                             const wabt::interp::Environment::MarkPoint &prefix) {
+            using namespace wabt::interp;
+            writer.Write<uint32_t>(static_cast<uint32_t>(prefix.modules_size));
+            for(wabt::Index i = 0; i < prefix.modules_size; i++) {
+                writer.WriteString(env->GetModule(i)->name);
+            }
+            writer.Write<uint32_t>(static_cast<uint32_t>(prefix.sigs_size));
+            for(wabt::Index i = 0; i < prefix.sigs_size; i++) {
+                writer.WriteTypes(env->GetFuncSignature(i)->param_types);
+                writer.WriteTypes(env->GetFuncSignature(i)->result_types);
+            }
+            writer.Write<uint32_t>(static_cast<uint32_t>(prefix.funcs_size));
+            for(wabt::Index i = 0; i < prefix.funcs_size; i++) {
+                Func *func = env->GetFunc(i);
+                writer.Write<uint8_t>(func->is_host);
+                writer.Write<uint32_t>(func->sig_index);
+                if(func->is_host) {
+                    writer.WriteString(wabt::cast<HostFunc>(func)->module_name);
+                    writer.WriteString(wabt::cast<HostFunc>(func)->field_name);
+                }
+            }
+            writer.Write<uint64_t>(prefix.memories_size);
+            writer.Write<uint64_t>(prefix.tables_size);
+            writer.Write<uint64_t>(prefix.globals_size);
+            writer.Write<uint64_t>(prefix.istream_size);
+        }
+
+        /**
+         * Check that loading a module on top of a prefix only added defined functions and modules,
+         * and that the prefix holds no state other than host functions
+         * @param env
+         * @param prefix
+         * @return true if the loaded module can be copied
+         */
+        bool IsCopyableModule(wabt::interp::Environment *env, const wabt::interp::Environment::MarkPoint &prefix) {
+            const wabt::interp::Environment::MarkPoint loaded = env->Mark();
+            if(prefix.memories_size != 0 || prefix.tables_size != 0 || prefix.globals_size != 0
+               || loaded.data_segments_size != prefix.data_segments_size
+               || loaded.elem_segments_size != prefix.elem_segments_size) {
+                return false;
+            }
+            for(wabt::Index i = prefix.funcs_size; i < loaded.funcs_size; i++) {
+                if(env->GetFunc(i)->is_host) {
+                    return false;
+                }
+            }
+            for(wabt::Index i = prefix.modules_size; i < loaded.modules_size; i++) {
+                if(env->GetModule(i)->is_host) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    WdbExecutor::WdbExecutor(wdb::WdbExecutor::Options options)
+            : m_cancellationToken(options.cancellationToken), m_fuel(options.fuel),
+              m_maxMemoryPages(options.maxMemoryPages), m_maxCallDepth(options.maxCallDepth),
+              m_maxHostCalls(options.maxHostCalls) {
         // Initialize environment
         m_env = new wabt::interp::Environment();
+        // The interpreter traps when its call stack is full
+        if(m_maxCallDepth > 0) {
+            options.threadOptions.call_stack_size = m_maxCallDepth;
+        }
         // Initialize thread
         m_thread = new wabt::interp::Thread(m_env, options.threadOptions);
         // Execute addition pre-setup configuration
@@ -18,15 +221,463 @@ namespace wdb {
         }
     }
 
+    WdbExecutor::~WdbExecutor() {
+        delete m_thread;
+        delete m_env;
+    }
+
     wabt::Result WdbExecutor::SetupEnvironment(std::vector<uint8_t> *fileData) {
+        return SetupEnvironment(fileData->data(), fileData->size());
+    }
+
+    wabt::Result WdbExecutor::SetupEnvironment(const uint8_t *data, size_t size) {
         // Configure binary reader options
         wabt::ReadBinaryOptions options;
         options.fail_on_custom_section_error = true;
         options.read_debug_names = true;
         options.stop_on_first_error = true;
         // Start reading the binary and setup the environment
+        m_setupMark = m_env->Mark();
         wabt::Errors errors;
-        return wabt::ReadBinaryInterp(m_env, fileData->data(), fileData->size(), options, &errors, &m_mainModule);
+        wabt::Result result = wabt::ReadBinaryInterp(m_env, data, size, options, &errors, &m_mainModule);
+        if(wabt::Succeeded(result)) {
+            IndexFunctionOffsets();
+            ReadFunctionNames(data, size);
+            IndexExports();
+        }
+        return result;
+    }
+
+    wabt::Result WdbExecutor::CloneEnvironment(wdb::WdbExecutor *prepared) {
+        using namespace wabt::interp;
+        Environment *from = prepared->m_env;
+        const Environment::MarkPoint &prefix = prepared->m_setupMark;
+        const Environment::MarkPoint current = m_env->Mark();
+        if(!prepared->m_mainModule || m_mainModule) {
+            return wabt::Result::Error;
+        }
+        // Host modules added before loading must match, and only provide functions
+        if(current.modules_size != prefix.modules_size || current.sigs_size != prefix.sigs_size
+           || current.funcs_size != prefix.funcs_size || current.memories_size != 0 || prefix.memories_size != 0
+           || current.tables_size != 0 || prefix.tables_size != 0 || current.globals_size != 0
+           || prefix.globals_size != 0 || current.istream_size != prefix.istream_size) {
+            return wabt::Result::Error;
+        }
+        for(wabt::Index i = 0; i < prefix.modules_size; i++) {
+            if(m_env->GetModule(i)->name != from->GetModule(i)->name) {
+                return wabt::Result::Error;
+            }
+        }
+        for(wabt::Index i = 0; i < prefix.sigs_size; i++) {
+            FuncSignature *sig = m_env->GetFuncSignature(i);
+            FuncSignature *fromSig = from->GetFuncSignature(i);
+            if(sig->param_types != fromSig->param_types || sig->result_types != fromSig->result_types) {
+                return wabt::Result::Error;
+            }
+        }
+        for(wabt::Index i = 0; i < prefix.funcs_size; i++) {
+            Func *func = m_env->GetFunc(i);
+            Func *fromFunc = from->GetFunc(i);
+            if(!func->is_host || !fromFunc->is_host || func->sig_index != fromFunc->sig_index
+               || wabt::cast<HostFunc>(func)->module_name != wabt::cast<HostFunc>(fromFunc)->module_name
+               || wabt::cast<HostFunc>(func)->field_name != wabt::cast<HostFunc>(fromFunc)->field_name) {
+                return wabt::Result::Error;
+            }
+        }
+        // Loading must only have added defined functions and modules
+        if(!IsCopyableModule(from, prefix)) {
+            return wabt::Result::Error;
+        }
+        const Environment::MarkPoint loaded = from->Mark();
+        // Copy everything the module has added
+        for(wabt::Index i = prefix.sigs_size; i < loaded.sigs_size; i++) {
+            m_env->EmplaceBackFuncSignature(*from->GetFuncSignature(i));
+        }
+        for(wabt::Index i = prefix.funcs_size; i < loaded.funcs_size; i++) {
+            auto fromFunc = wabt::cast<DefinedFunc>(from->GetFunc(i));
+            auto func = new DefinedFunc(fromFunc->sig_index);
+            func->offset = fromFunc->offset;
+            func->local_decl_count = fromFunc->local_decl_count;
+            func->local_count = fromFunc->local_count;
+            func->param_and_local_types = fromFunc->param_and_local_types;
+            m_env->EmplaceBackFunc(func);
+        }
+        for(wabt::Index i = 0; i < loaded.memories_size; i++) {
+            m_env->EmplaceBackMemory(*from->GetMemory(i));
+        }
+        for(wabt::Index i = 0; i < loaded.tables_size; i++) {
+            m_env->EmplaceBackTable(*from->GetTable(i));
+        }
+        for(wabt::Index i = 0; i < loaded.globals_size; i++) {
+            m_env->EmplaceBackGlobal(*from->GetGlobal(i));
+        }
+        for(wabt::Index i = prefix.modules_size; i < loaded.modules_size; i++) {
+            auto fromModule = wabt::cast<DefinedModule>(from->GetModule(i));
+            auto module = new DefinedModule();
+            module->name = fromModule->name;
+            module->exports = fromModule->exports;
+            module->export_bindings = fromModule->export_bindings;
+            module->memory_index = fromModule->memory_index;
+            module->table_index = fromModule->table_index;
+            module->imports = fromModule->imports;
+            module->start_func_index = fromModule->start_func_index;
+            module->istream_start = fromModule->istream_start;
+            module->istream_end = fromModule->istream_end;
+            m_env->EmplaceBackModule(module);
+            if(fromModule == prepared->m_mainModule) {
+                m_mainModule = module;
+            }
+        }
+        m_env->SetIstream(std::unique_ptr<wabt::OutputBuffer>(new wabt::OutputBuffer(from->istream())));
+        // Copy module information
+        m_setupMark = prefix;
+        m_functionNames = prepared->m_functionNames;
+        m_functionOffsets = prepared->m_functionOffsets;
+        IndexExports();
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::CopyHostImports(wdb::WdbExecutor *from) {
+        using namespace wabt::interp;
+        const Environment::MarkPoint &prefix = from->m_setupMark;
+        if(!from->m_mainModule || m_env->GetFuncCount() != 0 || m_env->GetModuleCount() != 0) {
+            return wabt::Result::Error;
+        }
+        for(wabt::Index i = 0; i < prefix.funcs_size; i++) {
+            if(!from->m_env->GetFunc(i)->is_host) {
+                return wabt::Result::Error;
+            }
+            auto func = wabt::cast<HostFunc>(from->m_env->GetFunc(i));
+            Module *module = m_env->FindRegisteredModule(func->module_name);
+            HostModule *hostModule = module && module->is_host ? wabt::cast<HostModule>(module)
+                                                               : m_env->AppendHostModule(func->module_name);
+            hostModule->AppendFuncExport(func->field_name, *from->m_env->GetFuncSignature(func->sig_index),
+                    [](const HostFunc *, const FuncSignature *, const TypedValues &, TypedValues &) {
+                        return wabt::interp::Result::TrapHostTrapped;
+                    });
+        }
+        // Host modules without functions or extra signatures are not reproduced
+        const Environment::MarkPoint current = m_env->Mark();
+        if(current.modules_size != prefix.modules_size || current.sigs_size != prefix.sigs_size
+           || current.funcs_size != prefix.funcs_size) {
+            return wabt::Result::Error;
+        }
+        return wabt::Result::Ok;
+    }
+
+    void WdbExecutor::GetHostPrefix(std::vector<uint8_t> *prefix) {
+        prefix->clear();
+        ImageWriter writer(prefix);
+        WriteHostPrefix(writer, m_env, m_mainModule ? m_setupMark : m_env->Mark());
+    }
+
+    wabt::Result WdbExecutor::SaveEnvironmentImage(std::vector<uint8_t> *image) {
+        using namespace wabt::interp;
+        const Environment::MarkPoint &prefix = m_setupMark;
+        // Only an untouched module can be saved
+        if(!m_mainModule || MainFunctionIsSet() || !IsCopyableModule(m_env, prefix)) {
+            return wabt::Result::Error;
+        }
+        const Environment::MarkPoint loaded = m_env->Mark();
+        image->clear();
+        ImageWriter writer(image);
+        writer.Write<uint32_t>(kImageMagic);
+        writer.Write<uint32_t>(kImageVersion);
+        writer.Write<uint32_t>(kIstreamFormat);
+        writer.Write<uint32_t>(kOpcodeCount);
+        writer.Write<uint32_t>(sizeof(Value));
+        // Host functions the image was loaded against
+        std::vector<uint8_t> hostPrefix;
+        ImageWriter prefixWriter(&hostPrefix);
+        WriteHostPrefix(prefixWriter, m_env, prefix);
+        writer.Write<uint32_t>(static_cast<uint32_t>(hostPrefix.size()));
+        writer.WriteBytes(hostPrefix.data(), hostPrefix.size());
+        // Signatures and functions
+        writer.Write<uint32_t>(static_cast<uint32_t>(loaded.sigs_size - prefix.sigs_size));
+        for(wabt::Index i = prefix.sigs_size; i < loaded.sigs_size; i++) {
+            writer.WriteTypes(m_env->GetFuncSignature(i)->param_types);
+            writer.WriteTypes(m_env->GetFuncSignature(i)->result_types);
+        }
+        writer.Write<uint32_t>(static_cast<uint32_t>(loaded.funcs_size - prefix.funcs_size));
+        for(wabt::Index i = prefix.funcs_size; i < loaded.funcs_size; i++) {
+            auto func = wabt::cast<DefinedFunc>(m_env->GetFunc(i));
+            writer.Write<uint32_t>(func->sig_index);
+            writer.Write<uint32_t>(func->offset);
+            writer.Write<uint32_t>(func->local_decl_count);
+            writer.Write<uint32_t>(func->local_count);
+            writer.WriteTypes(func->param_and_local_types);
+        }
+        // Memories without their chunks of zeros
+        writer.Write<uint32_t>(static_cast<uint32_t>(loaded.memories_size));
+        for(wabt::Index i = 0; i < loaded.memories_size; i++) {
+            Memory *memory = m_env->GetMemory(i);
+            const std::vector<char> &data = memory->data;
+            std::vector<uint64_t> chunks;
+            for(size_t offset = 0; offset < data.size(); offset += kImageChunkSize) {
+                auto end = data.begin() + std::min(offset + kImageChunkSize, data.size());
+                if(std::find_if(data.begin() + offset, end, [](char c) { return c != 0; }) != end) {
+                    chunks.emplace_back(offset);
+                }
+            }
+            writer.WriteLimits(memory->page_limits);
+            writer.Write<uint64_t>(data.size());
+            writer.Write<uint32_t>(static_cast<uint32_t>(chunks.size()));
+            for(uint64_t offset : chunks) {
+                writer.Write<uint64_t>(offset);
+                writer.WriteBytes(data.data() + offset, std::min(kImageChunkSize, data.size() - offset));
+            }
+        }
+        // Tables and globals
+        writer.Write<uint32_t>(static_cast<uint32_t>(loaded.tables_size));
+        for(wabt::Index i = 0; i < loaded.tables_size; i++) {
+            Table *table = m_env->GetTable(i);
+            writer.Write<int32_t>(static_cast<int32_t>(table->elem_type));
+            writer.WriteLimits(table->limits);
+            writer.Write<uint32_t>(static_cast<uint32_t>(table->func_indexes.size()));
+            writer.WriteBytes(table->func_indexes.data(), table->func_indexes.size() * sizeof(wabt::Index));
+        }
+        writer.Write<uint32_t>(static_cast<uint32_t>(loaded.globals_size));
+        for(wabt::Index i = 0; i < loaded.globals_size; i++) {
+            Global *global = m_env->GetGlobal(i);
+            writer.Write<int32_t>(static_cast<int32_t>(global->typed_value.type));
+            writer.WriteBytes(&global->typed_value.value, sizeof(Value));
+            writer.Write<uint8_t>(global->mutable_);
+            writer.Write<uint32_t>(global->import_index);
+        }
+        // Modules, imports are not saved since they are only needed while linking
+        writer.Write<uint32_t>(static_cast<uint32_t>(loaded.modules_size - prefix.modules_size));
+        for(wabt::Index i = prefix.modules_size; i < loaded.modules_size; i++) {
+            auto module = wabt::cast<DefinedModule>(m_env->GetModule(i));
+            writer.Write<uint8_t>(module == m_mainModule);
+            writer.WriteString(module->name);
+            writer.Write<uint32_t>(module->memory_index);
+            writer.Write<uint32_t>(module->table_index);
+            writer.Write<uint32_t>(module->start_func_index);
+            writer.Write<uint32_t>(module->istream_start);
+            writer.Write<uint32_t>(module->istream_end);
+            writer.Write<uint32_t>(static_cast<uint32_t>(module->exports.size()));
+            for(auto &e : module->exports) {
+                writer.WriteString(e.name);
+                writer.Write<uint32_t>(static_cast<uint32_t>(e.kind));
+                writer.Write<uint32_t>(e.index);
+            }
+        }
+        // Compiled code and debug names
+        const std::vector<uint8_t> &istream = m_env->istream().data;
+        writer.Write<uint64_t>(istream.size());
+        writer.WriteBytes(istream.data(), istream.size());
+        writer.Write<uint32_t>(static_cast<uint32_t>(m_functionNames.size()));
+        for(auto &name : m_functionNames) {
+            writer.WriteString(name);
+        }
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::LoadEnvironmentImage(const uint8_t *data, size_t size) {
+        using namespace wabt::interp;
+        if(m_mainModule) {
+            return wabt::Result::Error;
+        }
+        const Environment::MarkPoint current = m_env->Mark();
+        ImageReader reader(data, size);
+        // The istream is executed as is, only images of this interpreter are loaded
+        if(reader.Read<uint32_t>() != kImageMagic || reader.Read<uint32_t>() != kImageVersion
+           || reader.Read<uint32_t>() != kIstreamFormat || reader.Read<uint32_t>() != kOpcodeCount
+           || reader.Read<uint32_t>() != sizeof(Value)) {
+            return wabt::Result::Error;
+        }
+        // Host functions must match the ones the image was saved with
+        std::vector<uint8_t> hostPrefix;
+        ImageWriter prefixWriter(&hostPrefix);
+        WriteHostPrefix(prefixWriter, m_env, current);
+        uint32_t hostPrefixSize = reader.Read<uint32_t>();
+        const uint8_t *savedPrefix = reader.Skip(hostPrefixSize);
+        if(!savedPrefix || hostPrefixSize != hostPrefix.size()
+           || memcmp(savedPrefix, hostPrefix.data(), hostPrefixSize) != 0) {
+            return wabt::Result::Error;
+        }
+        // Counts are checked as they are read, indexes once everything is read
+        auto fail = [&]() {
+            m_env->ResetToMarkPoint(current);
+            m_mainModule = nullptr;
+            return wabt::Result::Error;
+        };
+        uint32_t sigCount = reader.Read<uint32_t>();
+        for(uint32_t i = 0; i < sigCount && reader.Ok(); i++) {
+            FuncSignature sig;
+            sig.param_types = reader.ReadTypes();
+            sig.result_types = reader.ReadTypes();
+            m_env->EmplaceBackFuncSignature(sig);
+        }
+        uint32_t funcCount = reader.Read<uint32_t>();
+        for(uint32_t i = 0; i < funcCount && reader.Ok(); i++) {
+            auto func = new DefinedFunc(reader.Read<uint32_t>());
+            func->offset = reader.Read<uint32_t>();
+            func->local_decl_count = reader.Read<uint32_t>();
+            func->local_count = reader.Read<uint32_t>();
+            func->param_and_local_types = reader.ReadTypes();
+            m_env->EmplaceBackFunc(func);
+        }
+        uint32_t memoryCount = reader.Read<uint32_t>();
+        for(uint32_t i = 0; i < memoryCount && reader.Ok(); i++) {
+            wabt::Limits limits = reader.ReadLimits();
+            uint64_t dataSize = reader.Read<uint64_t>();
+            if(limits.initial > WABT_MAX_PAGES || dataSize != limits.initial * WABT_PAGE_SIZE) {
+                return fail();
+            }
+            Memory memory(limits);
+            memory.data.assign(dataSize, 0);
+            uint32_t chunkCount = reader.Read<uint32_t>();
+            for(uint32_t j = 0; j < chunkCount && reader.Ok(); j++) {
+                uint64_t offset = reader.Read<uint64_t>();
+                if(offset >= dataSize) {
+                    return fail();
+                }
+                size_t chunkSize = std::min<size_t>(kImageChunkSize, dataSize - offset);
+                const uint8_t *chunk = reader.Skip(chunkSize);
+                if(chunk) {
+                    memcpy(memory.data.data() + offset, chunk, chunkSize);
+                }
+            }
+            m_env->EmplaceBackMemory(std::move(memory));
+        }
+        uint32_t tableCount = reader.Read<uint32_t>();
+        for(uint32_t i = 0; i < tableCount && reader.Ok(); i++) {
+            auto elemType = static_cast<wabt::Type>(reader.Read<int32_t>());
+            Table *table = m_env->EmplaceBackTable(elemType, reader.ReadLimits());
+            uint32_t entryCount = reader.Read<uint32_t>();
+            const uint8_t *entries = reader.Skip(static_cast<size_t>(entryCount) * sizeof(wabt::Index));
+            if(entries) {
+                table->func_indexes.resize(entryCount);
+                memcpy(table->func_indexes.data(), entries, entryCount * sizeof(wabt::Index));
+            }
+        }
+        uint32_t globalCount = reader.Read<uint32_t>();
+        for(uint32_t i = 0; i < globalCount && reader.Ok(); i++) {
+            Global *global = m_env->EmplaceBackGlobal();
+            global->typed_value.type = static_cast<wabt::Type>(reader.Read<int32_t>());
+            global->typed_value.value = reader.Read<Value>();
+            global->mutable_ = reader.Read<uint8_t>() != 0;
+            global->import_index = reader.Read<uint32_t>();
+        }
+        uint32_t moduleCount = reader.Read<uint32_t>();
+        for(uint32_t i = 0; i < moduleCount && reader.Ok(); i++) {
+            auto module = new DefinedModule();
+            bool isMain = reader.Read<uint8_t>() != 0;
+            module->name = reader.ReadString();
+            module->memory_index = reader.Read<uint32_t>();
+            module->table_index = reader.Read<uint32_t>();
+            module->start_func_index = reader.Read<uint32_t>();
+            module->istream_start = reader.Read<uint32_t>();
+            module->istream_end = reader.Read<uint32_t>();
+            uint32_t exportCount = reader.Read<uint32_t>();
+            for(uint32_t j = 0; j < exportCount && reader.Ok(); j++) {
+                std::string name = reader.ReadString();
+                auto kind = static_cast<wabt::ExternalKind>(reader.Read<uint32_t>());
+                module->AppendExport(kind, reader.Read<uint32_t>(), name);
+            }
+            m_env->EmplaceBackModule(module);
+            if(isMain) {
+                m_mainModule = module;
+            }
+        }
+        uint64_t istreamSize = reader.Read<uint64_t>();
+        const uint8_t *istreamData = reader.Skip(istreamSize);
+        uint32_t nameCount = reader.Read<uint32_t>();
+        std::vector<std::string> functionNames;
+        for(uint32_t i = 0; i < nameCount && reader.Ok(); i++) {
+            functionNames.emplace_back(reader.ReadString());
+        }
+        if(!reader.AtEnd() || !istreamData || !m_mainModule) {
+            return fail();
+        }
+        // Indexes must stay inside the loaded environment
+        const Environment::MarkPoint loaded = m_env->Mark();
+        auto isValidIndex = [&](wabt::ExternalKind kind, wabt::Index index) {
+            switch (kind) {
+                case wabt::ExternalKind::Func: return index < loaded.funcs_size;
+                case wabt::ExternalKind::Table: return index < loaded.tables_size;
+                case wabt::ExternalKind::Memory: return index < loaded.memories_size;
+                case wabt::ExternalKind::Global: return index < loaded.globals_size;
+                default: return false;
+            }
+        };
+        for(wabt::Index i = current.funcs_size; i < loaded.funcs_size; i++) {
+            auto func = wabt::cast<DefinedFunc>(m_env->GetFunc(i));
+            if(func->sig_index >= loaded.sigs_size || func->offset >= istreamSize) {
+                return fail();
+            }
+        }
+        for(wabt::Index i = 0; i < loaded.tables_size; i++) {
+            for(wabt::Index index : m_env->GetTable(i)->func_indexes) {
+                if(index != wabt::kInvalidIndex && index >= loaded.funcs_size) {
+                    return fail();
+                }
+            }
+        }
+        for(wabt::Index i = current.modules_size; i < loaded.modules_size; i++) {
+            auto module = wabt::cast<DefinedModule>(m_env->GetModule(i));
+            if((module->memory_index != wabt::kInvalidIndex && module->memory_index >= loaded.memories_size)
+               || (module->table_index != wabt::kInvalidIndex && module->table_index >= loaded.tables_size)
+               || (module->start_func_index != wabt::kInvalidIndex && module->start_func_index >= loaded.funcs_size)
+               || module->istream_start > module->istream_end || module->istream_end > istreamSize) {
+                return fail();
+            }
+            for(auto &e : module->exports) {
+                if(!isValidIndex(e.kind, e.index)) {
+                    return fail();
+                }
+            }
+        }
+        // The interpreter owns its istream, copy it out of the image
+        auto istream = new wabt::OutputBuffer();
+        istream->data.assign(istreamData, istreamData + istreamSize);
+        m_env->SetIstream(std::unique_ptr<wabt::OutputBuffer>(istream));
+        m_setupMark = current;
+        m_functionNames = std::move(functionNames);
+        IndexFunctionOffsets();
+        IndexExports();
+        return wabt::Result::Ok;
+    }
+
+    void WdbExecutor::IndexFunctionOffsets() {
+        m_functionOffsets.clear();
+        for(wabt::Index i = 0; i < m_env->GetFuncCount(); i++) {
+            wabt::interp::Func* func = m_env->GetFunc(i);
+            if(!func->is_host) {
+                m_functionOffsets.emplace_back(wabt::cast<wabt::interp::DefinedFunc>(func)->offset, i);
+            }
+        }
+        std::sort(m_functionOffsets.begin(), m_functionOffsets.end());
+    }
+
+    void WdbExecutor::ReadFunctionNames(const void *data, size_t size) {
+        // Names are optional, ignore a malformed name section
+        wabt::ReadBinaryOptions options;
+        options.read_debug_names = true;
+        options.fail_on_custom_section_error = false;
+        FunctionNameReader reader;
+        if(!wabt::Succeeded(wabt::ReadBinary(data, size, &reader, options))) {
+            return;
+        }
+        // Defined functions of the main module follow its imported ones in the name section
+        std::vector<wabt::Index> definedFunctions;
+        for(wabt::Index i = 0; i < m_env->GetFuncCount(); i++) {
+            wabt::interp::Func* func = m_env->GetFunc(i);
+            if(!func->is_host) {
+                auto offset = wabt::cast<wabt::interp::DefinedFunc>(func)->offset;
+                if(offset >= m_mainModule->istream_start && offset < m_mainModule->istream_end) {
+                    definedFunctions.emplace_back(i);
+                }
+            }
+        }
+        m_functionNames.assign(m_env->GetFuncCount(), std::string());
+        for(auto &name : reader.names) {
+            if(name.first >= reader.importedFunctions
+               && name.first - reader.importedFunctions < definedFunctions.size()) {
+                m_functionNames[definedFunctions[name.first - reader.importedFunctions]] = name.second;
+            }
+        }
     }
 
     wabt::Result WdbExecutor::AppendHostFuncExport(std::string hostName, std::string funcName,
@@ -47,12 +698,259 @@ namespace wdb {
         }
         // If casting was successful or new host module
         if(hostModule) {
-            hostModule->AppendFuncExport(funcName, funcSignature, std::move(callback));
+            // Host functions are identified by binding order in host call logs
+            uint32_t function = m_hostFuncCount++;
+            hostModule->AppendFuncExport(funcName, funcSignature,
+                    [this, function, callback](const wabt::interp::HostFunc *func,
+                                               const wabt::interp::FuncSignature *sig,
+                                               const wabt::interp::TypedValues &args,
+                                               wabt::interp::TypedValues &results) {
+                        return CallHostFunc(function, callback, func, sig, args, results);
+                    });
             return wabt::Result::Ok;
         }
         return wabt::Result::Error;
     }
 
+    wabt::interp::Result WdbExecutor::CallHostFunc(uint32_t function,
+                                                   const std::function<wabt::interp::Result(
+                                                           const wabt::interp::HostFunc *,
+                                                           const wabt::interp::FuncSignature *,
+                                                           const wabt::interp::TypedValues &,
+                                                           wabt::interp::TypedValues &)> &callback,
+                                                   const wabt::interp::HostFunc *func,
+                                                   const wabt::interp::FuncSignature *sig,
+                                                   const wabt::interp::TypedValues &args,
+                                                   wabt::interp::TypedValues &results) {
+        // Count host calls
+        if(m_maxHostCalls != UINT64_MAX) {
+            if(m_hostCalls >= m_maxHostCalls) {
+                m_exceededLimit = HOST_CALLS_LIMIT;
+                m_runLimit = HOST_CALLS_LIMIT;
+                return wabt::interp::Result::TrapHostTrapped;
+            }
+            m_hostCalls++;
+        }
+        if(m_hostCallLog.IsReplaying()) {
+            m_inHostCall = true;
+            wabt::interp::Result result = ReplayHostCall(function, args, results);
+            m_inHostCall = false;
+            return result;
+        }
+        // Executing again from a snapshot, the writes were already seen
+        if(m_hostCallHistoryPosition < m_hostCallHistory.size()) {
+            const WdbHostCallLog::Entry &entry = m_hostCallHistory[m_hostCallHistoryPosition];
+            if(IsLoggedCall(entry, function, args, results)) {
+                m_hostCallHistoryPosition++;
+                return ApplyLoggedCall(entry, results);
+            }
+            // The execution took another path, e.g. after editing memory, the rest is not reached
+            m_hostCallHistory.resize(m_hostCallHistoryPosition);
+        }
+        if(!m_hostCallLog.IsRecording() && !m_keepHostCallHistory) {
+            m_inHostCall = true;
+            wabt::interp::Result result = callback(func, sig, args, results);
+            m_inHostCall = false;
+            return result;
+        }
+        bool wasPending = m_pendingCall != nullptr;
+        WdbHostCallLog::Entry entry;
+        entry.instructionCount = m_instructionCount;
+        entry.function = function;
+        entry.args = args;
+        m_hostWrites.clear();
+        m_trackingHostWrites = true;
+        m_inHostCall = true;
+        entry.result = callback(func, sig, args, results);
+        m_inHostCall = false;
+        // A suspended call is recorded once its results are known, with what it writes until then
+        if(!wasPending && m_pendingCall) {
+            m_pendingEntry = std::move(entry);
+            m_pendingRecorded = true;
+            return m_pendingEntry.result;
+        }
+        entry.memoryWrites = TakeHostWrites();
+        if(entry.result == wabt::interp::Result::Ok) {
+            entry.results = results;
+        }
+        LogHostCall(entry);
+        return entry.result;
+    }
+
+    wabt::interp::Result WdbExecutor::ReplayHostCall(uint32_t function, const wabt::interp::TypedValues &args,
+                                                     wabt::interp::TypedValues &results) {
+        WdbHostCallLog::Entry entry;
+        if(!wabt::Succeeded(m_hostCallLog.Read(&entry)) || !IsLoggedCall(entry, function, args, results)) {
+            m_replayDiverged = true;
+            return wabt::interp::Result::TrapHostTrapped;
+        }
+        return ApplyLoggedCall(entry, results);
+    }
+
+    bool WdbExecutor::IsLoggedCall(const WdbHostCallLog::Entry &entry, uint32_t function,
+                                   const wabt::interp::TypedValues &args,
+                                   const wabt::interp::TypedValues &results) const {
+        return entry.function == function && entry.instructionCount == m_instructionCount
+               && (entry.result != wabt::interp::Result::Ok || entry.results.size() == results.size())
+               && WdbHostCallLog::ValuesEqual(entry.args, args);
+    }
+
+    wabt::interp::Result WdbExecutor::ApplyLoggedCall(const WdbHostCallLog::Entry &entry,
+                                                      wabt::interp::TypedValues &results) {
+        // Write what the host function wrote
+        for(const WdbHostCallLog::MemoryWrite &write : entry.memoryWrites) {
+            MutableMemoryView view;
+            if(!wabt::Succeeded(GetMutableMemoryView(write.memoryIndex, write.offset, write.bytes.size(), &view))) {
+                m_replayDiverged = true;
+                return wabt::interp::Result::TrapHostTrapped;
+            }
+            memcpy(view.data, write.bytes.data(), view.size);
+        }
+        if(entry.result == wabt::interp::Result::Ok) {
+            results = entry.results;
+        }
+        return entry.result;
+    }
+
+    void WdbExecutor::LogHostCall(const WdbHostCallLog::Entry &entry) {
+        m_hostCallLog.Write(entry);
+        if(m_keepHostCallHistory) {
+            m_hostCallHistory.push_back(entry);
+            m_hostCallHistoryPosition = m_hostCallHistory.size();
+        }
+    }
+
+    void WdbExecutor::KeepHostCallHistory(bool keep) {
+        m_keepHostCallHistory = keep;
+        if(!keep) {
+            m_hostCallHistory.clear();
+            m_hostCallHistoryPosition = 0;
+        }
+    }
+
+    std::vector<WdbHostCallLog::MemoryWrite> WdbExecutor::TakeHostWrites() {
+        m_trackingHostWrites = false;
+        std::vector<WdbHostCallLog::MemoryWrite> writes = std::move(m_hostWrites);
+        m_hostWrites.clear();
+        // Ranges no longer in the memory are dropped
+        writes.erase(std::remove_if(writes.begin(), writes.end(), [&](WdbHostCallLog::MemoryWrite &write) {
+            MemoryView view;
+            if(!wabt::Succeeded(GetMemoryView(write.memoryIndex, write.offset, write.bytes.size(), &view))) {
+                return true;
+            }
+            memcpy(write.bytes.data(), view.data, view.size);
+            return false;
+        }), writes.end());
+        return writes;
+    }
+
+    wabt::Result WdbExecutor::RecordHostCalls(std::string fileName) {
+        m_replayDiverged = false;
+        m_pendingRecorded = false;
+        return m_hostCallLog.OpenForRecording(std::move(fileName));
+    }
+
+    wabt::Result WdbExecutor::ReplayHostCalls(std::string fileName) {
+        m_replayDiverged = false;
+        m_pendingRecorded = false;
+        return m_hostCallLog.OpenForReplay(std::move(fileName));
+    }
+
+    wabt::Result WdbExecutor::CloseHostCallLog() {
+        // A call still suspended is not logged, it is still kept in the history
+        if(!m_keepHostCallHistory) {
+            m_pendingRecorded = false;
+            m_trackingHostWrites = false;
+            m_hostWrites.clear();
+        }
+        return m_hostCallLog.Close();
+    }
+
+    wabt::Result WdbExecutor::AppendAsyncHostFuncExport(std::string hostName, std::string funcName,
+                                                        wabt::interp::FuncSignature funcSignature,
+                                                        std::function<void(const wabt::interp::TypedValues &,
+                                                                           std::shared_ptr<WdbPendingCall>)> callback) {
+        m_asyncHostFuncCount++;
+        return AppendHostFuncExport(std::move(hostName), std::move(funcName), std::move(funcSignature),
+                [this, callback](const wabt::interp::HostFunc *func, const wabt::interp::FuncSignature *sig,
+                                 const wabt::interp::TypedValues &args, wabt::interp::TypedValues &results) {
+                    auto call = std::make_shared<WdbPendingCall>(args);
+                    callback(args, call);
+                    // Completed before returning
+                    if(call->IsComplete()) {
+                        if(call->HasFailed()) {
+                            return wabt::interp::Result::TrapHostTrapped;
+                        }
+                        wabt::interp::TypedValues values = call->GetResults();
+                        if(values.size() != results.size()) {
+                            return wabt::interp::Result::TrapHostResultTypeMismatch;
+                        }
+                        results = std::move(values);
+                        return wabt::interp::Result::Ok;
+                    }
+                    // Stop the thread, the arguments are already popped
+                    m_pendingCall = call;
+                    m_pendingResultTypes = sig->result_types;
+                    return wabt::interp::Result::TrapHostTrapped;
+                });
+    }
+
+    bool WdbExecutor::PrepareHostCallMap() {
+        if(m_hostCallMapFailed) {
+            return false;
+        }
+        if(!m_hostCallMap.IsBuilt(m_env)) {
+            if(!wabt::Succeeded(m_hostCallMap.Build(m_env))) {
+                m_hostCallMapFailed = true;
+                return false;
+            }
+            m_hostCallMap.SetStops(WdbInstructionDecoder::MayCallHost);
+        }
+        return true;
+    }
+
+    WdbExecutor::ExecuteStatus WdbExecutor::ResumePendingCall() {
+        if(!m_pendingCall->IsComplete()) {
+            return EXECUTE_SUSPENDED;
+        }
+        std::shared_ptr<WdbPendingCall> call = std::move(m_pendingCall);
+        m_pendingCall.reset();
+        wabt::interp::TypedValues results = call->GetResults();
+        if(m_pendingRecorded) {
+            // A failed call is replayed as a trap
+            m_pendingEntry.result = call->HasFailed() ? wabt::interp::Result::TrapHostTrapped
+                                                      : wabt::interp::Result::Ok;
+            if(!call->HasFailed()) {
+                m_pendingEntry.results = results;
+            }
+            m_pendingEntry.memoryWrites = TakeHostWrites();
+            LogHostCall(m_pendingEntry);
+            m_pendingRecorded = false;
+        }
+        // A tail call to the host cannot be completed from outside the interpreter
+        const std::vector<uint8_t> &istream = m_env->istream().data;
+        WdbInstructionDecoder decoder(istream.data(), istream.size());
+        WdbInstructionDecoder::Instruction instruction;
+        if(call->HasFailed() || results.size() != m_pendingResultTypes.size()
+           || !wabt::Succeeded(decoder.Decode(m_thread->pc(), &instruction))
+           || instruction.flow == WdbInstructionDecoder::FLOW_RETURN_CALL_INDIRECT) {
+            return EXECUTE_TRAPPED;
+        }
+        for(size_t i = 0; i < results.size(); i++) {
+            if(results[i].type != m_pendingResultTypes[i]
+               || m_thread->Push(results[i].value) != wabt::interp::Result::Ok) {
+                return EXECUTE_TRAPPED;
+            }
+        }
+        // Continue after the call as if the host function had returned
+        m_thread->set_pc(instruction.offset + instruction.length);
+        m_instructionCount++;
+        if(m_fuel != UINT64_MAX && m_fuel > 0) {
+            m_fuel--;
+        }
+        return EXECUTE_YIELDED;
+    }
+
     wabt::interp::Value WdbExecutor::GetStackAt(int i) {
         return m_thread->ValueAt(i);
     }
@@ -73,6 +971,152 @@ namespace wdb {
         return m_env->GetMemoryCount();
     }
 
+    wabt::Result WdbExecutor::GetMemoryView(int memoryIndex, uint64_t offset, uint64_t size, MemoryView *view) {
+        if(memoryIndex < 0 || memoryIndex >= GetMemoriesCount()) {
+            return wabt::Result::Error;
+        }
+        const std::vector<char> &data = m_env->GetMemory(memoryIndex)->data;
+        if(offset > data.size() || size > data.size() - offset) {
+            return wabt::Result::Error;
+        }
+        view->data = reinterpret_cast<const uint8_t*>(data.data()) + offset;
+        view->size = size;
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::GetMutableMemoryView(int memoryIndex, uint64_t offset, uint64_t size,
+                                                   MutableMemoryView *view) {
+        MemoryView constView;
+        if(!wabt::Succeeded(GetMemoryView(memoryIndex, offset, size, &constView))) {
+            return wabt::Result::Error;
+        }
+        view->data = reinterpret_cast<uint8_t*>(m_env->GetMemory(memoryIndex)->data.data()) + offset;
+        view->size = constView.size;
+        // The view is assumed written, its bytes are logged when the host call returns
+        if(m_trackingHostWrites && size > 0) {
+            m_hostWrites.emplace_back();
+            m_hostWrites.back().memoryIndex = static_cast<wabt::Index>(memoryIndex);
+            m_hostWrites.back().offset = offset;
+            m_hostWrites.back().bytes.resize(size);
+        }
+        if(m_trackDirtyPages) {
+            MarkPagesWritten(static_cast<wabt::Index>(memoryIndex), offset, size);
+        }
+        if((m_inHostCall || m_pendingCall) && size > 0) {
+            OnHostMemoryWrite(static_cast<wabt::Index>(memoryIndex), offset, size);
+        }
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::WriteMemory(int memoryIndex, uint64_t offset, const void *buffer, size_t size) {
+        MutableMemoryView view;
+        if(!wabt::Succeeded(GetMutableMemoryView(memoryIndex, offset, size, &view))) {
+            return wabt::Result::Error;
+        }
+        memcpy(view.data, buffer, view.size);
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::GetWholeMemoryView(int memoryIndex, MemoryView *view) {
+        if(memoryIndex < 0 || memoryIndex >= GetMemoriesCount()) {
+            return wabt::Result::Error;
+        }
+        return GetMemoryView(memoryIndex, 0, m_env->GetMemory(memoryIndex)->data.size(), view);
+    }
+
+    wabt::Result WdbExecutor::CopyMemory(int memoryIndex, uint64_t offset, void *buffer, size_t size) {
+        MemoryView view;
+        if(!wabt::Succeeded(GetMemoryView(memoryIndex, offset, size, &view))) {
+            return wabt::Result::Error;
+        }
+        memcpy(buffer, view.data, view.size);
+        return wabt::Result::Ok;
+    }
+
+    template <typename T>
+    wabt::Result WdbExecutor::ReadMemoryValue(int memoryIndex, uint64_t offset, T *value, ByteOrder order) {
+        // Memory is little endian, as are the hosts the interpreter runs on
+        uint8_t bytes[sizeof(T)];
+        if(!wabt::Succeeded(CopyMemory(memoryIndex, offset, bytes, sizeof(T)))) {
+            return wabt::Result::Error;
+        }
+        if(order == BIG_ENDIAN_ORDER) {
+            std::reverse(bytes, bytes + sizeof(T));
+        }
+        memcpy(value, bytes, sizeof(T));
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::ReadMemoryI32(int memoryIndex, uint64_t offset, uint32_t *value, ByteOrder order) {
+        return ReadMemoryValue(memoryIndex, offset, value, order);
+    }
+
+    wabt::Result WdbExecutor::ReadMemoryI64(int memoryIndex, uint64_t offset, uint64_t *value, ByteOrder order) {
+        return ReadMemoryValue(memoryIndex, offset, value, order);
+    }
+
+    wabt::Result WdbExecutor::ReadMemoryF32(int memoryIndex, uint64_t offset, float *value, ByteOrder order) {
+        return ReadMemoryValue(memoryIndex, offset, value, order);
+    }
+
+    wabt::Result WdbExecutor::ReadMemoryF64(int memoryIndex, uint64_t offset, double *value, ByteOrder order) {
+        return ReadMemoryValue(memoryIndex, offset, value, order);
+    }
+
+    wabt::Result WdbExecutor::ReadMemoryV128(int memoryIndex, uint64_t offset, wabt::v128 *value, ByteOrder order) {
+        return ReadMemoryValue(memoryIndex, offset, value, order);
+    }
+
+    wabt::Result WdbExecutor::SearchMemoryBytes(int memoryIndex, const void *pattern, size_t patternSize,
+                                                std::vector<uint64_t> *matches, WdbMemorySearch::Options options) {
+        MemoryView view;
+        if(!wabt::Succeeded(GetWholeMemoryView(memoryIndex, &view))) {
+            return wabt::Result::Error;
+        }
+        *matches = WdbMemorySearch::FindBytes(view.data, view.size, pattern, patternSize, options);
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::SearchMemoryI32(int memoryIndex, uint32_t min, uint32_t max, bool isSigned,
+                                              std::vector<uint64_t> *matches, WdbMemorySearch::Options options) {
+        MemoryView view;
+        if(!wabt::Succeeded(GetWholeMemoryView(memoryIndex, &view))) {
+            return wabt::Result::Error;
+        }
+        *matches = WdbMemorySearch::FindI32(view.data, view.size, min, max, isSigned, options);
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::SearchMemoryI64(int memoryIndex, uint64_t min, uint64_t max, bool isSigned,
+                                              std::vector<uint64_t> *matches, WdbMemorySearch::Options options) {
+        MemoryView view;
+        if(!wabt::Succeeded(GetWholeMemoryView(memoryIndex, &view))) {
+            return wabt::Result::Error;
+        }
+        *matches = WdbMemorySearch::FindI64(view.data, view.size, min, max, isSigned, options);
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::SearchMemoryF32(int memoryIndex, float min, float max, std::vector<uint64_t> *matches,
+                                              WdbMemorySearch::Options options) {
+        MemoryView view;
+        if(!wabt::Succeeded(GetWholeMemoryView(memoryIndex, &view))) {
+            return wabt::Result::Error;
+        }
+        *matches = WdbMemorySearch::FindF32(view.data, view.size, min, max, options);
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::SearchMemoryF64(int memoryIndex, double min, double max, std::vector<uint64_t> *matches,
+                                              WdbMemorySearch::Options options) {
+        MemoryView view;
+        if(!wabt::Succeeded(GetWholeMemoryView(memoryIndex, &view))) {
+            return wabt::Result::Error;
+        }
+        *matches = WdbMemorySearch::FindF64(view.data, view.size, min, max, options);
+        return wabt::Result::Ok;
+    }
+
     wabt::interp::Module* WdbExecutor::GetModuleAt(int index) {
         return m_env->GetModule(index);
     }
@@ -81,12 +1125,43 @@ namespace wdb {
         return m_env->GetModuleCount();
     }
 
+    void WdbExecutor::IndexExports() {
+        for(wabt::Index i = 0; i < m_env->GetModuleCount(); i++) {
+            GetExportIndex(m_env->GetModule(i));
+        }
+    }
+
+    const WdbExecutor::ExportIndex& WdbExecutor::GetExportIndex(wabt::interp::Module *module) {
+        ExportIndex &index = m_exportIndexes[module];
+        // Host modules may get new exports after the index was built
+        if(index.exports != module->exports.data() || index.exportCount != module->exports.size()) {
+            for(auto &exports : index.byKind) {
+                exports.clear();
+            }
+            for(const wabt::interp::Export &e : module->exports) {
+                index.byKind[static_cast<int>(e.kind)].emplace_back(&e);
+            }
+            index.exports = module->exports.data();
+            index.exportCount = module->exports.size();
+        }
+        return index;
+    }
+
+    const wabt::interp::Export* WdbExecutor::FindExport(wabt::interp::Module *module, const std::string &name,
+                                                        wabt::ExternalKind kind) {
+        const wabt::interp::Export *e = module->GetExport(name);
+        return e && e->kind == kind ? e : nullptr;
+    }
+
+    const std::vector<const wabt::interp::Export*>& WdbExecutor::GetModuleExports(wabt::interp::Module *module,
+                                                                                  wabt::ExternalKind kind) {
+        return GetExportIndex(module).byKind[static_cast<int>(kind)];
+    }
+
     std::vector<wabt::interp::Export> WdbExecutor::GetExportedModuleFunctions(wabt::interp::Module *module) {
         std::vector<wabt::interp::Export> result;
-        for(wabt::interp::Export e : module->exports) {
-            if(e.kind == wabt::ExternalKind::Func) {
-                result.emplace_back(e);
-            }
+        for(const wabt::interp::Export *e : GetModuleExports(module, wabt::ExternalKind::Func)) {
+            result.emplace_back(*e);
         }
         return result;
     }
@@ -94,11 +1169,10 @@ namespace wdb {
     wabt::Result WdbExecutor::SearchExportedModuleFunction(wabt::interp::DefinedModule *module, std::string name,
                                                            wabt::interp::Export **pExport) {
         *pExport = nullptr;
-        for(auto e : module->exports) {
-            if(e.kind == wabt::ExternalKind::Func && e.name == name) {
-                *pExport = new wabt::interp::Export(e.name, e.kind, e.index);
-                return wabt::Result::Ok;
-            }
+        const wabt::interp::Export *e = FindExport(module, name, wabt::ExternalKind::Func);
+        if(e) {
+            *pExport = new wabt::interp::Export(e->name, e->kind, e->index);
+            return wabt::Result::Ok;
         }
         return wabt::Result::Error;
     }
@@ -111,13 +1185,82 @@ namespace wdb {
         return m_env->GetFuncSignature(index);
     }
 
+    std::string WdbExecutor::GetFunctionName(wabt::Index index) {
+        // Debug name
+        if(index < m_functionNames.size() && !m_functionNames[index].empty()) {
+            return m_functionNames[index];
+        }
+        // Host function name
+        wabt::interp::Func* func = m_env->GetFunc(index);
+        if(func->is_host) {
+            auto hostFunc = wabt::cast<wabt::interp::HostFunc>(func);
+            return hostFunc->module_name + "." + hostFunc->field_name;
+        }
+        // Export name
+        if(m_mainModule) {
+            for(auto &e : m_mainModule->exports) {
+                if(e.kind == wabt::ExternalKind::Func && e.index == index) {
+                    return e.name;
+                }
+            }
+        }
+        return "func[" + std::to_string(index) + "]";
+    }
+
+    wabt::Index WdbExecutor::GetFunctionAt(wabt::interp::IstreamOffset offset) {
+        // Find the last function starting at or before offset
+        auto it = std::upper_bound(m_functionOffsets.begin(), m_functionOffsets.end(),
+                                   std::make_pair(offset, wabt::kInvalidIndex));
+        if(it == m_functionOffsets.begin()) {
+            return wabt::kInvalidIndex;
+        }
+        return (--it)->second;
+    }
+
+    wabt::Index WdbExecutor::GetIndirectCallee(const WdbInstructionDecoder::Instruction &instruction) {
+        // The table element index is on top of the stack
+        wabt::interp::Table *table = m_env->GetTable(static_cast<wabt::Index>(instruction.operands[0]));
+        if(!table || m_thread->NumValues() == 0) {
+            return wabt::kInvalidIndex;
+        }
+        uint32_t element = m_thread->ValueAt(m_thread->NumValues() - 1).i32;
+        return element < table->func_indexes.size() ? table->func_indexes[element] : wabt::kInvalidIndex;
+    }
+
+    bool WdbExecutor::IsHostCall(const WdbInstructionDecoder::Instruction &instruction) {
+        if(instruction.flow == WdbInstructionDecoder::FLOW_CALL_HOST) {
+            return true;
+        }
+        if(instruction.flow != WdbInstructionDecoder::FLOW_CALL_INDIRECT
+           && instruction.flow != WdbInstructionDecoder::FLOW_RETURN_CALL_INDIRECT) {
+            return false;
+        }
+        wabt::Index callee = GetIndirectCallee(instruction);
+        return callee < m_env->GetFuncCount() && m_env->GetFunc(callee)->is_host;
+    }
+
     wabt::Result WdbExecutor::SetMainFunction(wabt::interp::Func *function) {
         // Can only have one main function
         if(MainFunctionIsSet() || !CanBeMain(function)) {
             return wabt::Result::Error;
         }
+        // Limit memory growth from here on, prepared and cached environments keep the module limits,
+        // every memory is checked before any is changed
+        for(wabt::Index i = 0; i < m_env->GetMemoryCount(); i++) {
+            if(m_env->GetMemory(i)->page_limits.initial > m_maxMemoryPages) {
+                return wabt::Result::Error;
+            }
+        }
+        for(wabt::Index i = 0; i < m_env->GetMemoryCount(); i++) {
+            wabt::interp::Memory *memory = m_env->GetMemory(i);
+            if(!memory->page_limits.has_max || memory->page_limits.max > m_maxMemoryPages) {
+                memory->page_limits.has_max = true;
+                memory->page_limits.max = m_maxMemoryPages;
+            }
+        }
         // Set main function
         m_mainFunction = wabt::cast<wabt::interp::DefinedFunc>(function);
+        m_exceededLimit = NO_LIMIT;
         // Reset thread components
         m_thread->Reset();
         // Set the pc to the function index
@@ -126,19 +1269,58 @@ namespace wdb {
     }
 
     wabt::Result WdbExecutor::Execute() {
-        if(CanRun()) {
-            wabt::interp::Result result = wabt::interp::Result::Ok;
-            // Keep executing instructions
-            while(result == wabt::interp::Result::Ok) {
-                result = m_thread->Run(INT_MAX);
+        // Keep executing instructions, a suspended execution can only be resumed by ExecuteFor
+        ExecuteStatus status = EXECUTE_YIELDED;
+        while(status == EXECUTE_YIELDED) {
+            status = ExecuteFor(UINT64_MAX);
+        }
+        return status == EXECUTE_RETURNED ? wabt::Result::Ok : wabt::Result::Error;
+    }
+
+    WdbExecutor::ExecuteStatus WdbExecutor::ExecuteFor(uint64_t instructions, uint64_t microseconds) {
+        if(!CanRun()) {
+            return EXECUTE_FAILED;
+        }
+        if(m_pendingCall) {
+            ExecuteStatus status = ResumePendingCall();
+            if(status != EXECUTE_YIELDED) {
+                return status;
+            }
+            // The completed call instruction is part of the budget
+            if(instructions <= 1) {
+                return EXECUTE_YIELDED;
             }
+            instructions--;
+        }
+        uint64_t deadline = 0;
+        if(microseconds > 0) {
+            deadline = WdbTimer::ReadTicks() + (uint64_t) (microseconds * 1000.0 / WdbTimer::GetNanosecondsPerTick());
+        }
+        // Run in slices when something has to be checked in between
+        const bool checked = deadline != 0 || m_cancellationToken;
+        while(instructions > 0) {
+            if(m_cancellationToken && m_cancellationToken->IsCancelled()) {
+                return EXECUTE_CANCELLED;
+            }
+            int slice = (int) std::min<uint64_t>(instructions, checked ? kCheckInstructions : INT_MAX);
+            wabt::interp::Result result = RunInstructions(slice);
             // Main function has returned
             if(result == wabt::interp::Result::Returned) {
                 SetMainFunctionReturned();
-                return wabt::Result::Ok;
+                return EXECUTE_RETURNED;
+            }
+            if(result != wabt::interp::Result::Ok) {
+                if(m_pendingCall) {
+                    return EXECUTE_SUSPENDED;
+                }
+                return m_runLimit != NO_LIMIT ? EXECUTE_LIMIT_EXCEEDED : EXECUTE_TRAPPED;
+            }
+            instructions -= slice;
+            if(deadline != 0 && WdbTimer::ReadTicks() >= deadline) {
+                break;
             }
         }
-        return wabt::Result::Error;
+        return EXECUTE_YIELDED;
     }
 
     wabt::Result WdbExecutor::GetMainFunctionReturnedValues(wabt::interp::TypedValues &values) {
@@ -165,17 +1347,450 @@ namespace wdb {
     }
 
     void WdbExecutor::PostOutput(std::string text) {
-        if(m_outputStreamHandler) {
+        if(m_outputMuted) {
+            return;
+        }
+        if(m_outputChannel) {
+            m_outputChannel->Write(text.data(), text.size());
+        } else if(m_outputStreamHandler) {
             m_outputStreamHandler(std::move(text));
         }
     }
 
+    void WdbExecutor::PostOutput(const char *data, size_t size) {
+        if(m_outputMuted) {
+            return;
+        }
+        if(m_outputChannel) {
+            m_outputChannel->Write(data, size);
+        } else if(m_outputStreamHandler) {
+            m_outputStreamHandler(std::string(data, size));
+        }
+    }
+
     void WdbExecutor::PostError(std::string text) {
-        if(m_errorStreamHandler) {
+        if(m_outputMuted) {
+            return;
+        }
+        if(m_errorChannel) {
+            m_errorChannel->Write(text.data(), text.size());
+        } else if(m_errorStreamHandler) {
             m_errorStreamHandler(std::move(text));
         }
     }
 
+    void WdbExecutor::PostError(const char *data, size_t size) {
+        if(m_outputMuted) {
+            return;
+        }
+        if(m_errorChannel) {
+            m_errorChannel->Write(data, size);
+        } else if(m_errorStreamHandler) {
+            m_errorStreamHandler(std::string(data, size));
+        }
+    }
+
+    void WdbExecutor::SetFuel(uint64_t fuel) {
+        m_fuel = fuel;
+        if(m_exceededLimit == FUEL_LIMIT) {
+            m_exceededLimit = NO_LIMIT;
+        }
+    }
+
+    wabt::interp::Result WdbExecutor::RunInstructions(int count) {
+        m_runLimit = NO_LIMIT;
+        // A suspended host call completes before anything else runs, the pc is still on its instruction
+        if(m_pendingCall) {
+            if(ResumePendingCall() != EXECUTE_YIELDED) {
+                return wabt::interp::Result::TrapHostTrapped;
+            }
+            if(--count <= 0) {
+                return wabt::interp::Result::Ok;
+            }
+        }
+        if(m_fuel == 0) {
+            // Nothing ran, the thread is left as it was
+            m_exceededLimit = FUEL_LIMIT;
+            m_runLimit = FUEL_LIMIT;
+            return wabt::interp::Result::TrapHostTrapped;
+        }
+        // Cap the batch instead of counting every instruction
+        if(m_fuel != UINT64_MAX) {
+            count = (int) std::min<uint64_t>(count, m_fuel);
+        }
+        // Run host calls alone so that a suspended call leaves the pc on it,
+        // and the instruction count is exact at logged calls whatever drives the execution
+        const bool splitAtHostCalls = m_asyncHostFuncCount > 0 || m_hostCallLog.IsRecording()
+                                      || m_hostCallLog.IsReplaying() || m_keepHostCallHistory;
+        // Run calls and returns alone to follow the call frames
+        if(m_trackCallFrames && !PrepareCallFrameMap()) {
+            m_trackCallFrames = false;
+            m_callFrames.clear();
+        }
+        // Run memory writes alone to stamp the pages they write
+        if(m_trackDirtyPages && !PrepareDirtyPageMap()) {
+            m_trackDirtyPages = false;
+            m_pageGenerations.clear();
+        }
+        wabt::interp::Result result = wabt::interp::Result::Ok;
+        while(count > 0 && result == wabt::interp::Result::Ok) {
+            int batch = count;
+            const WdbInstructionDecoder::Instruction *callOrReturn = nullptr;
+            WdbSnapshot::Frame frame;
+            if(m_trackCallFrames) {
+                wabt::interp::IstreamOffset pc = m_thread->pc();
+                if(!m_callFrameMap.IsStop(pc)) {
+                    batch = std::min(batch, m_callFrameMap.GetRunLength(pc));
+                } else {
+                    batch = 1;
+                    callOrReturn = m_callFrameMap.GetInstruction(pc);
+                    frame.callOffset = pc;
+                    if(callOrReturn->flow == WdbInstructionDecoder::FLOW_CALL_INDIRECT
+                       || callOrReturn->flow == WdbInstructionDecoder::FLOW_RETURN_CALL_INDIRECT) {
+                        frame.tableIndex = static_cast<wabt::Index>(callOrReturn->operands[0]);
+                        wabt::Index top = m_thread->NumValues();
+                        frame.element = top > 0 ? m_thread->ValueAt(top - 1).i32 : 0;
+                        frame.function = GetIndirectCallee(*callOrReturn);
+                    }
+                }
+            } else if(splitAtHostCalls) {
+                wabt::interp::IstreamOffset pc = m_thread->pc();
+                if(!PrepareHostCallMap() || m_hostCallMap.IsStop(pc)) {
+                    batch = 1;
+                } else {
+                    batch = std::min(batch, m_hostCallMap.GetRunLength(pc));
+                }
+            }
+            if(m_trackDirtyPages) {
+                wabt::interp::IstreamOffset pc = m_thread->pc();
+                if(!m_dirtyPageMap.IsStop(pc)) {
+                    batch = std::min(batch, m_dirtyPageMap.GetRunLength(pc));
+                } else {
+                    batch = 1;
+                    MarkInstructionWrites(*m_dirtyPageMap.GetInstruction(pc));
+                }
+            }
+            result = m_thread->Run(batch);
+            // A trap or return does not tell how many instructions ran and ends the execution,
+            // only a completed batch is charged
+            if(result == wabt::interp::Result::Ok) {
+                if(m_fuel != UINT64_MAX) {
+                    m_fuel -= batch;
+                }
+                m_instructionCount += batch;
+                count -= batch;
+                if(callOrReturn) {
+                    UpdateCallFrames(*callOrReturn, frame);
+                }
+            }
+        }
+        if(result == wabt::interp::Result::TrapCallStackExhausted && m_maxCallDepth > 0) {
+            m_exceededLimit = CALL_DEPTH_LIMIT;
+            m_runLimit = CALL_DEPTH_LIMIT;
+        }
+        return result;
+    }
+
+    bool WdbExecutor::PrepareCallFrameMap() {
+        if(!m_callFrameMap.IsBuilt(m_env)) {
+            if(!wabt::Succeeded(m_callFrameMap.Build(m_env))) {
+                return false;
+            }
+            m_callFrameMap.SetStops(WdbInstructionDecoder::IsCallOrReturn);
+        }
+        return true;
+    }
+
+    bool WdbExecutor::PrepareDirtyPageMap() {
+        if(!m_dirtyPageMap.IsBuilt(m_env)) {
+            if(!wabt::Succeeded(m_dirtyPageMap.Build(m_env))) {
+                return false;
+            }
+            m_dirtyPageMap.SetStops([](const WdbInstructionDecoder::Instruction &instruction) {
+                WdbInstructionDecoder::MemoryAccess access;
+                return WdbInstructionDecoder::GetMemoryAccess(instruction, &access) && access.writes;
+            });
+        }
+        return true;
+    }
+
+    void WdbExecutor::MarkInstructionWrites(const WdbInstructionDecoder::Instruction &instruction) {
+        WdbInstructionDecoder::MemoryAccess access;
+        const wabt::Index top = m_thread->NumValues();
+        if(!WdbInstructionDecoder::GetMemoryAccess(instruction, &access) || !access.writes
+           || top < std::max(access.addressSlot, access.sizeSlot)) {
+            return;
+        }
+        // The operands are still on the stack, the written range is at the address operand
+        uint32_t base = m_thread->ValueAt(top - access.addressSlot).i32;
+        uint64_t address = static_cast<uint64_t>(base) + access.offset;
+        uint64_t size = access.sizeSlot != 0 ? m_thread->ValueAt(top - access.sizeSlot).i32 : access.size;
+        MarkPagesWritten(access.memoryIndex, address, size);
+    }
+
+    void WdbExecutor::MarkPagesWritten(wabt::Index memoryIndex, uint64_t offset, uint64_t size) {
+        if(size == 0 || memoryIndex >= m_env->GetMemoryCount()) {
+            return;
+        }
+        // An access past the end traps, only the pages within the memory are stamped
+        const uint64_t memorySize = m_env->GetMemory(memoryIndex)->data.size();
+        if(offset >= memorySize) {
+            return;
+        }
+        const uint64_t last = (std::min(offset + size, memorySize) - 1) / kRestorePageSize;
+        if(m_pageGenerations.size() <= memoryIndex) {
+            m_pageGenerations.resize(memoryIndex + 1);
+        }
+        std::vector<uint64_t> &pages = m_pageGenerations[memoryIndex];
+        if(pages.size() <= last) {
+            pages.resize(last + 1, 0);
+        }
+        for(uint64_t page = offset / kRestorePageSize; page <= last; page++) {
+            pages[page] = m_writeGeneration;
+        }
+    }
+
+    uint64_t WdbExecutor::GetPageGeneration(wabt::Index memoryIndex, uint64_t page) const {
+        if(memoryIndex >= m_pageGenerations.size() || page >= m_pageGenerations[memoryIndex].size()) {
+            return 0;
+        }
+        return m_pageGenerations[memoryIndex][page];
+    }
+
+    void WdbExecutor::ShareSnapshotPages(const std::vector<WdbSnapshot::Memory> &memories, uint64_t generation) {
+        m_sharedPages.resize(memories.size());
+        for(size_t i = 0; i < memories.size(); i++) {
+            m_sharedPages[i].assign(memories[i].pages.begin(), memories[i].pages.end());
+        }
+        m_sharedPagesGeneration = generation;
+    }
+
+    wabt::Result WdbExecutor::TrackDirtyPages() {
+        if(m_trackDirtyPages) {
+            return wabt::Result::Ok;
+        }
+        if(!PrepareDirtyPageMap()) {
+            return wabt::Result::Error;
+        }
+        // Pages written before are unknown, older snapshots are compared
+        m_pageGenerations.clear();
+        m_trackedSinceGeneration = m_writeGeneration;
+        m_trackDirtyPages = true;
+        return wabt::Result::Ok;
+    }
+
+    void WdbExecutor::UpdateCallFrames(const WdbInstructionDecoder::Instruction &instruction,
+                                       const WdbSnapshot::Frame &frame) {
+        switch(instruction.flow) {
+            case WdbInstructionDecoder::FLOW_CALL:
+                m_callFrames.push_back(frame);
+                break;
+            case WdbInstructionDecoder::FLOW_CALL_INDIRECT:
+                // A host function is called without entering a frame
+                if(m_thread->pc() != instruction.offset + instruction.length) {
+                    m_callFrames.push_back(frame);
+                }
+                break;
+            case WdbInstructionDecoder::FLOW_RETURN_CALL_INDIRECT:
+                // A host function returns in place of the caller, a defined one replaces its frame
+                if(frame.function < m_env->GetFuncCount() && m_env->GetFunc(frame.function)->is_host
+                   && !m_callFrames.empty()) {
+                    m_callFrames.pop_back();
+                }
+                break;
+            case WdbInstructionDecoder::FLOW_RETURN:
+                if(!m_callFrames.empty()) {
+                    m_callFrames.pop_back();
+                }
+                break;
+            default:
+                // Tail calls keep the return pc of the frame
+                break;
+        }
+    }
+
+    wabt::Result WdbExecutor::EnterCallFrame(const WdbSnapshot::Frame &frame) {
+        m_thread->set_pc(frame.callOffset);
+        if(frame.tableIndex == wabt::kInvalidIndex) {
+            return m_thread->Run(1) == wabt::interp::Result::Ok ? wabt::Result::Ok : wabt::Result::Error;
+        }
+        // The table may have changed since the call, the element points at the called function while calling
+        wabt::interp::Table *table = m_env->GetTable(frame.tableIndex);
+        if(!table || frame.element >= table->func_indexes.size()) {
+            return wabt::Result::Error;
+        }
+        wabt::Index saved = table->func_indexes[frame.element];
+        table->func_indexes[frame.element] = frame.function;
+        wabt::interp::Value element;
+        element.i32 = frame.element;
+        wabt::interp::Result result = m_thread->Push(element);
+        if(result == wabt::interp::Result::Ok) {
+            result = m_thread->Run(1);
+        }
+        table->func_indexes[frame.element] = saved;
+        return result == wabt::interp::Result::Ok ? wabt::Result::Ok : wabt::Result::Error;
+    }
+
+    wabt::Result WdbExecutor::TrackCallFrames() {
+        if(m_trackCallFrames) {
+            return wabt::Result::Ok;
+        }
+        if(MayBeInCall() || !PrepareCallFrameMap()) {
+            return wabt::Result::Error;
+        }
+        m_callFrames.clear();
+        m_trackCallFrames = true;
+        return wabt::Result::Ok;
+    }
+
+    bool WdbExecutor::MayBeInCall() {
+        if(!MainFunctionIsSet() || MainFunctionHasReturned() || m_trackCallFrames) {
+            return false;
+        }
+        // The main function enters with an empty stack, a call to it with an empty stack is not told apart
+        return m_thread->pc() != m_mainFunction->offset || m_thread->NumValues() != 0;
+    }
+
+    wabt::Result WdbExecutor::Snapshot(WdbSnapshot *snapshot) {
+        if(!m_mainModule || MayBeInCall() || m_pendingCall) {
+            return wabt::Result::Error;
+        }
+        snapshot->env = m_env;
+        // Pages unchanged since the last snapshot taken or restored are shared with it, they are found
+        // by their write generation when tracking dirty pages and by comparing them otherwise
+        const bool tracked = m_trackDirtyPages && m_sharedPagesGeneration != 0
+                             && m_sharedPagesGeneration >= m_trackedSinceGeneration;
+        std::vector<WdbSnapshot::Memory> memories(m_env->GetMemoryCount());
+        for(wabt::Index i = 0; i < memories.size(); i++) {
+            const wabt::interp::Memory *memory = m_env->GetMemory(i);
+            WdbSnapshot::Memory &saved = memories[i];
+            saved.pageLimits = memory->page_limits;
+            saved.size = memory->data.size();
+            for(size_t offset = 0; offset < saved.size; offset += kRestorePageSize) {
+                const size_t size = std::min<size_t>(kRestorePageSize, saved.size - offset);
+                const char *bytes = memory->data.data() + offset;
+                const size_t page = offset / kRestorePageSize;
+                std::shared_ptr<const std::vector<char>> shared;
+                if(i < m_sharedPages.size() && page < m_sharedPages[i].size()) {
+                    shared = m_sharedPages[i][page].lock();
+                }
+                if(!shared || shared->size() != size
+                   || (tracked ? GetPageGeneration(i, page) > m_sharedPagesGeneration
+                               : memcmp(shared->data(), bytes, size) != 0)) {
+                    shared = std::make_shared<const std::vector<char>>(bytes, bytes + size);
+                }
+                saved.pages.emplace_back(std::move(shared));
+            }
+        }
+        snapshot->memories = std::move(memories);
+        snapshot->tables.clear();
+        for(wabt::Index i = 0; i < m_env->GetTableCount(); i++) {
+            snapshot->tables.emplace_back(m_env->GetTable(i)->func_indexes);
+        }
+        snapshot->globals.clear();
+        for(wabt::Index i = 0; i < m_env->GetGlobalCount(); i++) {
+            snapshot->globals.emplace_back(m_env->GetGlobal(i)->typed_value);
+        }
+        snapshot->values.clear();
+        for(wabt::Index i = 0; i < m_thread->NumValues(); i++) {
+            snapshot->values.emplace_back(m_thread->ValueAt(i));
+        }
+        snapshot->frames = m_callFrames;
+        snapshot->pc = m_thread->pc();
+        snapshot->mainFunction = m_mainFunction;
+        snapshot->mainReturned = m_mainReturned;
+        snapshot->instructionCount = m_instructionCount;
+        snapshot->fuel = m_fuel;
+        snapshot->hostCalls = m_hostCalls;
+        snapshot->exceededLimit = m_exceededLimit;
+        snapshot->hostCallHistoryPosition = m_hostCallHistoryPosition;
+        snapshot->hostCallLogPosition = m_hostCallLog.GetReadPosition();
+        // Pages written from here on get a later generation
+        snapshot->writeGeneration = m_trackDirtyPages ? m_writeGeneration++ : 0;
+        ShareSnapshotPages(snapshot->memories, snapshot->writeGeneration);
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbExecutor::Restore(const WdbSnapshot &snapshot) {
+        if(snapshot.env != m_env || snapshot.memories.size() != m_env->GetMemoryCount()
+           || snapshot.tables.size() != m_env->GetTableCount() || snapshot.globals.size() != m_env->GetGlobalCount()) {
+            return wabt::Result::Error;
+        }
+        // Pages written since a snapshot taken while tracking have a later generation,
+        // the pages of other snapshots are compared
+        const bool tracked = m_trackDirtyPages && snapshot.writeGeneration != 0
+                             && snapshot.writeGeneration >= m_trackedSinceGeneration;
+        for(wabt::Index i = 0; i < snapshot.memories.size(); i++) {
+            wabt::interp::Memory *memory = m_env->GetMemory(i);
+            const WdbSnapshot::Memory &saved = snapshot.memories[i];
+            const size_t currentSize = memory->data.size();
+            // Pages cut off are stamped so that growing the memory again does not share them
+            if(m_trackDirtyPages && saved.size < currentSize) {
+                MarkPagesWritten(i, saved.size, currentSize - saved.size);
+            }
+            // Undo memory growth, then only write the pages that changed
+            memory->page_limits = saved.pageLimits;
+            memory->data.resize(saved.size);
+            for(size_t page = 0; page < saved.pages.size(); page++) {
+                const std::vector<char> &bytes = *saved.pages[page];
+                const size_t offset = page * kRestorePageSize;
+                bool changed;
+                if(offset >= currentSize) {
+                    // Grown back from zeros
+                    changed = true;
+                } else if(tracked) {
+                    changed = GetPageGeneration(i, page) > snapshot.writeGeneration;
+                } else {
+                    changed = memcmp(memory->data.data() + offset, bytes.data(), bytes.size()) != 0;
+                }
+                if(changed) {
+                    memcpy(memory->data.data() + offset, bytes.data(), bytes.size());
+                    // Restored pages differ from later snapshots
+                    if(m_trackDirtyPages) {
+                        MarkPagesWritten(i, offset, bytes.size());
+                    }
+                }
+            }
+        }
+        // Memory now holds the pages of the snapshot, the next snapshot shares them
+        ShareSnapshotPages(snapshot.memories, m_trackDirtyPages ? m_writeGeneration++ : 0);
+        for(wabt::Index i = 0; i < snapshot.tables.size(); i++) {
+            m_env->GetTable(i)->func_indexes = snapshot.tables[i];
+        }
+        for(wabt::Index i = 0; i < snapshot.globals.size(); i++) {
+            m_env->GetGlobal(i)->typed_value = snapshot.globals[i];
+        }
+        // Rebuild the stack, then the call frames above the main function frame
+        m_thread->Reset();
+        for(const wabt::interp::Value &value : snapshot.values) {
+            m_thread->Push(value);
+        }
+        for(const WdbSnapshot::Frame &frame : snapshot.frames) {
+            if(!wabt::Succeeded(EnterCallFrame(frame))) {
+                return wabt::Result::Error;
+            }
+        }
+        m_callFrames = snapshot.frames;
+        m_thread->set_pc(snapshot.pc);
+        m_mainFunction = snapshot.mainFunction;
+        m_mainReturned = snapshot.mainReturned;
+        m_instructionCount = snapshot.instructionCount;
+        m_fuel = snapshot.fuel;
+        m_hostCalls = snapshot.hostCalls;
+        m_exceededLimit = static_cast<Limit>(snapshot.exceededLimit);
+        m_runLimit = NO_LIMIT;
+        // A host call suspended since the snapshot is abandoned, the calls made since are made again
+        m_pendingCall.reset();
+        m_pendingRecorded = false;
+        m_trackingHostWrites = false;
+        m_hostWrites.clear();
+        m_hostCallHistoryPosition = std::min(snapshot.hostCallHistoryPosition, m_hostCallHistory.size());
+        if(m_hostCallLog.IsReplaying()) {
+            m_hostCallLog.SetReadPosition(snapshot.hostCallLogPosition);
+        }
+        return wabt::Result::Ok;
+    }
+
     bool WdbExecutor::CanRun() {
         return MainFunctionIsSet() && !MainFunctionHasReturned();
     }
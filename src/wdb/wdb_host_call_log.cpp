@@ -0,0 +1,268 @@
+#include <wdb/wdb_host_call_log.h>
+#include <cstring>
+
+namespace wdb {
+    namespace {
+        // Log header, bump the version when the layout changes
+        const uint32_t kLogMagic = 0x48424457;
+        const uint32_t kLogVersion = 2;
+        // Buffered bytes written to the file at once
+        const size_t kFlushSize = 64 * 1024;
+
+        void WriteU32(std::vector<uint8_t>& out, uint32_t value) {
+            uint8_t bytes[sizeof(uint32_t)];
+            memcpy(bytes, &value, sizeof(uint32_t));
+            out.insert(out.end(), bytes, bytes + sizeof(uint32_t));
+        }
+
+        void WriteLeb128(std::vector<uint8_t>& out, uint64_t value) {
+            do {
+                uint8_t byte = value & 0x7f;
+                value >>= 7;
+                out.push_back(value != 0 ? (byte | 0x80) : byte);
+            } while(value != 0);
+        }
+
+        /**
+         * Get the stored size of a value type
+         * @param type
+         * @return size or 0 if not supported
+         */
+        size_t GetValueSize(wabt::Type type) {
+            switch(type) {
+                case wabt::Type::I32:
+                case wabt::Type::F32:
+                    return sizeof(uint32_t);
+                case wabt::Type::I64:
+                case wabt::Type::F64:
+                    return sizeof(uint64_t);
+                case wabt::Type::V128:
+                    return sizeof(wabt::v128);
+                default:
+                    return 0;
+            }
+        }
+
+        // Values are stored as their type followed by their little endian bits
+        void WriteValues(std::vector<uint8_t>& out, const wabt::interp::TypedValues& values) {
+            WriteLeb128(out, values.size());
+            for(const wabt::interp::TypedValue& value : values) {
+                out.push_back(static_cast<uint8_t>(static_cast<int32_t>(value.type) & 0x7f));
+                auto bytes = reinterpret_cast<const uint8_t*>(&value.value);
+                out.insert(out.end(), bytes, bytes + GetValueSize(value.type));
+            }
+        }
+
+        // Read values from a log, reading past the end fails the reader
+        class LogReader {
+        public:
+            LogReader(const uint8_t* data, size_t size, size_t offset)
+                    : m_data(data), m_size(size), m_offset(offset) {}
+
+            const uint8_t* Skip(size_t size) {
+                if(!m_ok || size > m_size - m_offset) {
+                    m_ok = false;
+                    return nullptr;
+                }
+                const uint8_t* bytes = m_data + m_offset;
+                m_offset += size;
+                return bytes;
+            }
+
+            uint64_t ReadLeb128() {
+                uint64_t value = 0;
+                for(unsigned shift = 0; shift < 64; shift += 7) {
+                    const uint8_t* byte = Skip(1);
+                    if(!byte) {
+                        return 0;
+                    }
+                    value |= static_cast<uint64_t>(*byte & 0x7f) << shift;
+                    if((*byte & 0x80) == 0) {
+                        return value;
+                    }
+                }
+                m_ok = false;
+                return 0;
+            }
+
+            void ReadValues(wabt::interp::TypedValues* values) {
+                values->clear();
+                uint64_t count = ReadLeb128();
+                for(uint64_t i = 0; i < count && m_ok; i++) {
+                    const uint8_t* type = Skip(1);
+                    if(!type) {
+                        return;
+                    }
+                    // Types are stored as their low 7 bits of the negative type code
+                    wabt::interp::TypedValue value(static_cast<wabt::Type>(static_cast<int32_t>(*type) - 0x80));
+                    size_t size = GetValueSize(value.type);
+                    const uint8_t* bytes = Skip(size);
+                    if(size == 0 || !bytes) {
+                        m_ok = false;
+                        return;
+                    }
+                    memset(&value.value, 0, sizeof(value.value));
+                    memcpy(&value.value, bytes, size);
+                    values->emplace_back(value);
+                }
+            }
+
+            bool Ok() const { return m_ok; }
+            size_t GetOffset() const { return m_offset; }
+        private:
+            const uint8_t* m_data;
+            size_t m_size;
+            size_t m_offset;
+            bool m_ok = true;
+        };
+    }
+
+    bool WdbHostCallLog::ValuesEqual(const wabt::interp::TypedValues &a, const wabt::interp::TypedValues &b) {
+        if(a.size() != b.size()) {
+            return false;
+        }
+        for(size_t i = 0; i < a.size(); i++) {
+            if(a[i].type != b[i].type || memcmp(&a[i].value, &b[i].value, GetValueSize(a[i].type)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    WdbHostCallLog::~WdbHostCallLog() {
+        Close();
+    }
+
+    wabt::Result WdbHostCallLog::OpenForRecording(std::string fileName) {
+        Close();
+        m_file = fopen(fileName.c_str(), "wb");
+        if(!m_file) {
+            return wabt::Result::Error;
+        }
+        WriteU32(m_buffer, kLogMagic);
+        WriteU32(m_buffer, kLogVersion);
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbHostCallLog::OpenForReplay(std::string fileName) {
+        Close();
+        if(!wabt::Succeeded(m_mappedFile.Open(std::move(fileName)))) {
+            return wabt::Result::Error;
+        }
+        uint32_t header[2];
+        if(m_mappedFile.GetSize() < sizeof(header)) {
+            m_mappedFile.Close();
+            return wabt::Result::Error;
+        }
+        memcpy(header, m_mappedFile.GetData(), sizeof(header));
+        if(header[0] != kLogMagic || header[1] != kLogVersion) {
+            m_mappedFile.Close();
+            return wabt::Result::Error;
+        }
+        m_readOffset = sizeof(header);
+        m_replaying = true;
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbHostCallLog::Close() {
+        wabt::Result result = wabt::Result::Ok;
+        if(m_file) {
+            result = Flush();
+            if(fclose(m_file) != 0) {
+                result = wabt::Result::Error;
+            }
+            m_file = nullptr;
+        }
+        m_mappedFile.Close();
+        m_replaying = false;
+        m_readOffset = 0;
+        m_buffer.clear();
+        m_writeFailed = false;
+        m_lastInstructionCount = 0;
+        return result;
+    }
+
+    void WdbHostCallLog::Write(const wdb::WdbHostCallLog::Entry &entry) {
+        if(!m_file) {
+            return;
+        }
+        WriteLeb128(m_buffer, entry.instructionCount - m_lastInstructionCount);
+        WriteLeb128(m_buffer, entry.function);
+        m_buffer.push_back(static_cast<uint8_t>(entry.result));
+        WriteValues(m_buffer, entry.args);
+        WriteValues(m_buffer, entry.results);
+        WriteLeb128(m_buffer, entry.memoryWrites.size());
+        for(const MemoryWrite &write : entry.memoryWrites) {
+            WriteLeb128(m_buffer, write.memoryIndex);
+            WriteLeb128(m_buffer, write.offset);
+            WriteLeb128(m_buffer, write.bytes.size());
+            m_buffer.insert(m_buffer.end(), write.bytes.begin(), write.bytes.end());
+        }
+        m_lastInstructionCount = entry.instructionCount;
+        if(m_buffer.size() >= kFlushSize) {
+            Flush();
+        }
+    }
+
+    wabt::Result WdbHostCallLog::Flush() {
+        if(!m_file) {
+            return wabt::Result::Error;
+        }
+        if(!m_buffer.empty()) {
+            if(fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size()) {
+                m_writeFailed = true;
+            }
+            m_buffer.clear();
+        }
+        if(fflush(m_file) != 0) {
+            m_writeFailed = true;
+        }
+        return m_writeFailed ? wabt::Result::Error : wabt::Result::Ok;
+    }
+
+    wabt::Result WdbHostCallLog::Read(wdb::WdbHostCallLog::Entry *entry) {
+        if(!m_replaying || m_readOffset >= m_mappedFile.GetSize()) {
+            return wabt::Result::Error;
+        }
+        LogReader reader(m_mappedFile.GetData(), m_mappedFile.GetSize(), m_readOffset);
+        entry->instructionCount = m_lastInstructionCount + reader.ReadLeb128();
+        entry->function = static_cast<uint32_t>(reader.ReadLeb128());
+        const uint8_t* result = reader.Skip(1);
+        if(result) {
+            entry->result = static_cast<wabt::interp::Result>(*result);
+        }
+        reader.ReadValues(&entry->args);
+        reader.ReadValues(&entry->results);
+        entry->memoryWrites.clear();
+        uint64_t writeCount = reader.ReadLeb128();
+        for(uint64_t i = 0; i < writeCount && reader.Ok(); i++) {
+            MemoryWrite write;
+            write.memoryIndex = static_cast<wabt::Index>(reader.ReadLeb128());
+            write.offset = reader.ReadLeb128();
+            uint64_t size = reader.ReadLeb128();
+            const uint8_t* bytes = reader.Skip(size);
+            if(bytes) {
+                write.bytes.assign(bytes, bytes + size);
+                entry->memoryWrites.emplace_back(std::move(write));
+            }
+        }
+        if(!reader.Ok()) {
+            return wabt::Result::Error;
+        }
+        m_readOffset = reader.GetOffset();
+        m_lastInstructionCount = entry->instructionCount;
+        return wabt::Result::Ok;
+    }
+
+    WdbHostCallLog::ReadPosition WdbHostCallLog::GetReadPosition() const {
+        ReadPosition position;
+        position.offset = m_readOffset;
+        position.instructionCount = m_lastInstructionCount;
+        return position;
+    }
+
+    void WdbHostCallLog::SetReadPosition(const wdb::WdbHostCallLog::ReadPosition &position) {
+        m_readOffset = position.offset;
+        m_lastInstructionCount = position.instructionCount;
+    }
+}
@@ -0,0 +1,973 @@
+#include <wdb/wdb_instruction_decoder.h>
+#include <wabt/src/interp/interp-internal.h>
+#include <wabt/src/cast.h>
+#include <initializer_list>
+#include <inttypes.h>
+#include <cstring>
+
+namespace wdb {
+    namespace {
+        struct OpcodeInfo {
+            WdbInstructionDecoder::Immediates immediates;
+            WdbInstructionDecoder::Flow flow;
+        };
+
+        const size_t kOpcodeCount = static_cast<size_t>(wabt::Opcode::Invalid) + 1;
+
+        void SetOpcodeInfo(std::vector<OpcodeInfo> &table, std::initializer_list<wabt::Opcode::Enum> opcodes,
+                           WdbInstructionDecoder::Immediates immediates,
+                           WdbInstructionDecoder::Flow flow = WdbInstructionDecoder::FLOW_NEXT) {
+            for(wabt::Opcode::Enum opcode : opcodes) {
+                table[opcode].immediates = immediates;
+                table[opcode].flow = flow;
+            }
+        }
+
+        std::vector<OpcodeInfo> BuildOpcodeTable() {
+            using wabt::Opcode;
+            std::vector<OpcodeInfo> table(kOpcodeCount);
+            // Loads, stores and atomics carry a memory index and an offset, other opcodes have no immediates
+            for(size_t i = 0; i < static_cast<size_t>(Opcode::Invalid); i++) {
+                Opcode opcode(static_cast<Opcode::Enum>(i));
+                table[i].immediates = opcode.GetMemorySize() != 0 ? WdbInstructionDecoder::IMM_U32_U32
+                                                                  : WdbInstructionDecoder::IMM_NONE;
+                table[i].flow = WdbInstructionDecoder::FLOW_NEXT;
+            }
+            // Control flow
+            SetOpcodeInfo(table, {Opcode::Br}, WdbInstructionDecoder::IMM_U32, WdbInstructionDecoder::FLOW_BRANCH);
+            SetOpcodeInfo(table, {Opcode::BrIf, Opcode::InterpBrUnless}, WdbInstructionDecoder::IMM_U32,
+                          WdbInstructionDecoder::FLOW_BRANCH_IF);
+            SetOpcodeInfo(table, {Opcode::BrTable}, WdbInstructionDecoder::IMM_U32_U32,
+                          WdbInstructionDecoder::FLOW_BRANCH_TABLE);
+            SetOpcodeInfo(table, {Opcode::Call}, WdbInstructionDecoder::IMM_U32, WdbInstructionDecoder::FLOW_CALL);
+            SetOpcodeInfo(table, {Opcode::CallIndirect}, WdbInstructionDecoder::IMM_U32_U32,
+                          WdbInstructionDecoder::FLOW_CALL_INDIRECT);
+            SetOpcodeInfo(table, {Opcode::InterpCallHost}, WdbInstructionDecoder::IMM_U32,
+                          WdbInstructionDecoder::FLOW_CALL_HOST);
+            SetOpcodeInfo(table, {Opcode::Return}, WdbInstructionDecoder::IMM_NONE, WdbInstructionDecoder::FLOW_RETURN);
+            SetOpcodeInfo(table, {Opcode::ReturnCall}, WdbInstructionDecoder::IMM_U32,
+                          WdbInstructionDecoder::FLOW_RETURN_CALL);
+            SetOpcodeInfo(table, {Opcode::ReturnCallIndirect}, WdbInstructionDecoder::IMM_U32_U32,
+                          WdbInstructionDecoder::FLOW_RETURN_CALL_INDIRECT);
+            SetOpcodeInfo(table, {Opcode::Unreachable}, WdbInstructionDecoder::IMM_NONE,
+                          WdbInstructionDecoder::FLOW_TRAP);
+            SetOpcodeInfo(table, {Opcode::InterpData}, WdbInstructionDecoder::IMM_DATA,
+                          WdbInstructionDecoder::FLOW_DATA);
+            // Other immediates
+            SetOpcodeInfo(table, {Opcode::MemorySize, Opcode::MemoryGrow, Opcode::I32Const, Opcode::F32Const,
+                                  Opcode::LocalGet, Opcode::GlobalGet, Opcode::LocalSet, Opcode::GlobalSet,
+                                  Opcode::LocalTee, Opcode::InterpAlloca}, WdbInstructionDecoder::IMM_U32);
+            SetOpcodeInfo(table, {Opcode::InterpDropKeep}, WdbInstructionDecoder::IMM_U32_U32);
+            SetOpcodeInfo(table, {Opcode::I64Const, Opcode::F64Const}, WdbInstructionDecoder::IMM_U64);
+            SetOpcodeInfo(table, {Opcode::I8X16ExtractLaneS, Opcode::I8X16ExtractLaneU, Opcode::I16X8ExtractLaneS,
+                                  Opcode::I16X8ExtractLaneU, Opcode::I32X4ExtractLane, Opcode::I64X2ExtractLane,
+                                  Opcode::F32X4ExtractLane, Opcode::F64X2ExtractLane, Opcode::I8X16ReplaceLane,
+                                  Opcode::I16X8ReplaceLane, Opcode::I32X4ReplaceLane, Opcode::I64X2ReplaceLane,
+                                  Opcode::F32X4ReplaceLane, Opcode::F64X2ReplaceLane}, WdbInstructionDecoder::IMM_U8);
+            SetOpcodeInfo(table, {Opcode::V128Const, Opcode::V8X16Shuffle}, WdbInstructionDecoder::IMM_V128);
+            // Bulk memory operations take the memory index, memory.init also the data segment index
+            SetOpcodeInfo(table, {Opcode::MemoryCopy, Opcode::MemoryFill}, WdbInstructionDecoder::IMM_U32);
+            SetOpcodeInfo(table, {Opcode::MemoryInit}, WdbInstructionDecoder::IMM_U32_U32);
+            // The following opcodes are either never generated or not supported by the interpreter
+            SetOpcodeInfo(table, {Opcode::MemoryDrop, Opcode::TableInit, Opcode::TableDrop, Opcode::TableCopy, Opcode::Block,
+                                  Opcode::Catch, Opcode::Else, Opcode::End, Opcode::If, Opcode::IfExcept,
+                                  Opcode::Loop, Opcode::Rethrow, Opcode::Throw, Opcode::Try, Opcode::Invalid},
+                          WdbInstructionDecoder::IMM_UNSUPPORTED);
+            return table;
+        }
+
+        const std::vector<OpcodeInfo>& GetOpcodeTable() {
+            static const std::vector<OpcodeInfo> table = BuildOpcodeTable();
+            return table;
+        }
+
+        // Read the operands of a decoded instruction in istream order
+        class OperandReader {
+        public:
+            explicit OperandReader(const WdbInstructionDecoder::Instruction &instruction)
+                    : m_instruction(instruction) {}
+
+            uint32_t ReadU32() {
+                // A v128 is read as four words
+                if(m_instruction.immediates == WdbInstructionDecoder::IMM_V128) {
+                    uint32_t word = static_cast<uint32_t>(m_instruction.operands[m_next / 2] >> (32 * (m_next % 2)));
+                    m_next++;
+                    return word;
+                }
+                return static_cast<uint32_t>(m_instruction.operands[m_next++]);
+            }
+
+            uint64_t ReadU64() { return m_instruction.operands[m_next++]; }
+            uint8_t ReadU8() { return static_cast<uint8_t>(m_instruction.operands[m_next++]); }
+        private:
+            const WdbInstructionDecoder::Instruction &m_instruction;
+            size_t m_next = 0;
+        };
+    }
+
+    WdbInstructionDecoder::WdbInstructionDecoder(const uint8_t *istream, size_t size) : m_istream(istream),
+                                                                                        m_size(size) {}
+
+    wabt::Result WdbInstructionDecoder::Decode(wabt::interp::IstreamOffset offset, Instruction *instruction) const {
+        using namespace wabt::interp;
+        if(offset >= m_size || m_size - offset < sizeof(uint32_t)) {
+            return wabt::Result::Error;
+        }
+        const uint8_t *pc = &m_istream[offset];
+        wabt::Opcode opcode = ReadOpcode(&pc);
+        if(opcode.IsInvalid()) {
+            return wabt::Result::Error;
+        }
+        const OpcodeInfo &info = GetOpcodeTable()[opcode];
+        // Compute the size of the immediates
+        size_t available = m_size - (pc - m_istream);
+        size_t immediatesSize = 0;
+        switch (info.immediates) {
+            case IMM_NONE:
+                break;
+            case IMM_U32:
+                immediatesSize = sizeof(uint32_t);
+                break;
+            case IMM_U32_U32:
+            case IMM_U64:
+                immediatesSize = 2 * sizeof(uint32_t);
+                break;
+            case IMM_U8:
+                immediatesSize = sizeof(uint8_t);
+                break;
+            case IMM_V128:
+                immediatesSize = 4 * sizeof(uint32_t);
+                break;
+            case IMM_DATA:
+                if(available < sizeof(uint32_t)) {
+                    return wabt::Result::Error;
+                }
+                immediatesSize = sizeof(uint32_t) + ReadU32At(pc);
+                break;
+            case IMM_UNSUPPORTED:
+                return wabt::Result::Error;
+        }
+        if(immediatesSize > available) {
+            return wabt::Result::Error;
+        }
+        // Fill instruction
+        instruction->offset = offset;
+        instruction->length = static_cast<uint32_t>(pc - &m_istream[offset] + immediatesSize);
+        instruction->opcode = opcode;
+        instruction->flow = info.flow;
+        instruction->target = kInvalidIstreamOffset;
+        instruction->tableSize = 0;
+        instruction->immediates = info.immediates;
+        instruction->operands[0] = 0;
+        instruction->operands[1] = 0;
+        switch (info.immediates) {
+            case IMM_U32:
+            case IMM_DATA:
+                instruction->operands[0] = ReadU32At(pc);
+                break;
+            case IMM_U32_U32:
+                instruction->operands[0] = ReadU32At(pc);
+                instruction->operands[1] = ReadU32At(pc + sizeof(uint32_t));
+                break;
+            case IMM_U64:
+                memcpy(&instruction->operands[0], pc, sizeof(uint64_t));
+                break;
+            case IMM_U8:
+                instruction->operands[0] = *pc;
+                break;
+            case IMM_V128:
+                memcpy(instruction->operands, pc, 2 * sizeof(uint64_t));
+                break;
+            default:
+                break;
+        }
+        switch (info.flow) {
+            case FLOW_BRANCH:
+            case FLOW_BRANCH_IF:
+            case FLOW_CALL:
+            case FLOW_CALL_HOST:
+            case FLOW_RETURN_CALL:
+                instruction->target = ReadU32(&pc);
+                break;
+            case FLOW_BRANCH_TABLE: {
+                instruction->tableSize = ReadU32(&pc) + 1;
+                instruction->target = ReadU32(&pc);
+                // Make sure the table is within the istream
+                if(instruction->target > m_size ||
+                   (m_size - instruction->target) / WABT_TABLE_ENTRY_SIZE < instruction->tableSize) {
+                    return wabt::Result::Error;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        return wabt::Result::Ok;
+    }
+
+    wabt::interp::IstreamOffset WdbInstructionDecoder::GetTableTarget(const Instruction &instruction,
+                                                                      wabt::Index entry) const {
+        using namespace wabt::interp;
+        const uint8_t *entryPc = &m_istream[instruction.target + entry * WABT_TABLE_ENTRY_SIZE];
+        return ReadU32At(entryPc + WABT_TABLE_ENTRY_OFFSET_OFFSET);
+    }
+
+    std::string WdbInstructionDecoder::Format(const Instruction &instruction) {
+        using namespace wabt;
+        using namespace wabt::interp;
+        OperandReader operands(instruction);
+        MemoryStream stream;
+        Opcode opcode(instruction.opcode);
+        switch (opcode) {
+            case Opcode::Select:
+            case Opcode::V128BitSelect:
+                stream.Writef("%s %%[-3], %%[-2], %%[-1]", opcode.GetName());
+                break;
+
+            case Opcode::Br:
+                stream.Writef("%s @%u", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::BrIf:
+                stream.Writef("%s @%u, %%[-1]", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::BrTable: {
+                const Index num_targets = operands.ReadU32();
+                const IstreamOffset table_offset = operands.ReadU32();
+                stream.Writef("%s %%[-1], $#%" PRIindex ", table:$%u",
+                              opcode.GetName(), num_targets, table_offset);
+                break;
+            }
+
+            case Opcode::Nop:
+            case Opcode::Return:
+            case Opcode::Unreachable:
+            case Opcode::Drop:
+                stream.Writef("%s", opcode.GetName());
+                break;
+
+            case Opcode::MemorySize: {
+                const Index memory_index = operands.ReadU32();
+                stream.Writef("%s $%" PRIindex "", opcode.GetName(), memory_index);
+                break;
+            }
+
+            case Opcode::I32Const:
+                stream.Writef("%s %u", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::I64Const:
+                stream.Writef("%s %" PRIu64 "", opcode.GetName(), operands.ReadU64());
+                break;
+
+            case Opcode::F32Const:
+                stream.Writef("%s %g", opcode.GetName(),
+                              Bitcast<float>(operands.ReadU32()));
+                break;
+
+            case Opcode::F64Const:
+                stream.Writef("%s %g", opcode.GetName(),
+                              Bitcast<double>(operands.ReadU64()));
+                break;
+
+            case Opcode::LocalGet:
+            case Opcode::GlobalGet:
+                stream.Writef("%s $%u", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::LocalSet:
+            case Opcode::GlobalSet:
+            case Opcode::LocalTee:
+                stream.Writef("%s $%u, %%[-1]", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::Call:
+            case Opcode::ReturnCall:
+                stream.Writef("%s @%u", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::CallIndirect:
+            case Opcode::ReturnCallIndirect: {
+                const Index table_index = operands.ReadU32();
+                stream.Writef("%s $%" PRIindex ":%u, %%[-1]", opcode.GetName(),
+                              table_index, operands.ReadU32());
+                break;
+            }
+
+            case Opcode::InterpCallHost:
+                stream.Writef("%s $%u", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::I32AtomicLoad:
+            case Opcode::I64AtomicLoad:
+            case Opcode::I32AtomicLoad8U:
+            case Opcode::I32AtomicLoad16U:
+            case Opcode::I64AtomicLoad8U:
+            case Opcode::I64AtomicLoad16U:
+            case Opcode::I64AtomicLoad32U:
+            case Opcode::I32Load8S:
+            case Opcode::I32Load8U:
+            case Opcode::I32Load16S:
+            case Opcode::I32Load16U:
+            case Opcode::I64Load8S:
+            case Opcode::I64Load8U:
+            case Opcode::I64Load16S:
+            case Opcode::I64Load16U:
+            case Opcode::I64Load32S:
+            case Opcode::I64Load32U:
+            case Opcode::I32Load:
+            case Opcode::I64Load:
+            case Opcode::F32Load:
+            case Opcode::F64Load:
+            case Opcode::V128Load: {
+                const Index memory_index = operands.ReadU32();
+                stream.Writef("%s $%" PRIindex ":%%[-1]+$%u", opcode.GetName(),
+                              memory_index, operands.ReadU32());
+                break;
+            }
+
+            case Opcode::AtomicNotify:
+            case Opcode::I32AtomicStore:
+            case Opcode::I64AtomicStore:
+            case Opcode::I32AtomicStore8:
+            case Opcode::I32AtomicStore16:
+            case Opcode::I64AtomicStore8:
+            case Opcode::I64AtomicStore16:
+            case Opcode::I64AtomicStore32:
+            case Opcode::I32AtomicRmwAdd:
+            case Opcode::I64AtomicRmwAdd:
+            case Opcode::I32AtomicRmw8AddU:
+            case Opcode::I32AtomicRmw16AddU:
+            case Opcode::I64AtomicRmw8AddU:
+            case Opcode::I64AtomicRmw16AddU:
+            case Opcode::I64AtomicRmw32AddU:
+            case Opcode::I32AtomicRmwSub:
+            case Opcode::I64AtomicRmwSub:
+            case Opcode::I32AtomicRmw8SubU:
+            case Opcode::I32AtomicRmw16SubU:
+            case Opcode::I64AtomicRmw8SubU:
+            case Opcode::I64AtomicRmw16SubU:
+            case Opcode::I64AtomicRmw32SubU:
+            case Opcode::I32AtomicRmwAnd:
+            case Opcode::I64AtomicRmwAnd:
+            case Opcode::I32AtomicRmw8AndU:
+            case Opcode::I32AtomicRmw16AndU:
+            case Opcode::I64AtomicRmw8AndU:
+            case Opcode::I64AtomicRmw16AndU:
+            case Opcode::I64AtomicRmw32AndU:
+            case Opcode::I32AtomicRmwOr:
+            case Opcode::I64AtomicRmwOr:
+            case Opcode::I32AtomicRmw8OrU:
+            case Opcode::I32AtomicRmw16OrU:
+            case Opcode::I64AtomicRmw8OrU:
+            case Opcode::I64AtomicRmw16OrU:
+            case Opcode::I64AtomicRmw32OrU:
+            case Opcode::I32AtomicRmwXor:
+            case Opcode::I64AtomicRmwXor:
+            case Opcode::I32AtomicRmw8XorU:
+            case Opcode::I32AtomicRmw16XorU:
+            case Opcode::I64AtomicRmw8XorU:
+            case Opcode::I64AtomicRmw16XorU:
+            case Opcode::I64AtomicRmw32XorU:
+            case Opcode::I32AtomicRmwXchg:
+            case Opcode::I64AtomicRmwXchg:
+            case Opcode::I32AtomicRmw8XchgU:
+            case Opcode::I32AtomicRmw16XchgU:
+            case Opcode::I64AtomicRmw8XchgU:
+            case Opcode::I64AtomicRmw16XchgU:
+            case Opcode::I64AtomicRmw32XchgU:
+            case Opcode::I32Store8:
+            case Opcode::I32Store16:
+            case Opcode::I32Store:
+            case Opcode::I64Store8:
+            case Opcode::I64Store16:
+            case Opcode::I64Store32:
+            case Opcode::I64Store:
+            case Opcode::F32Store:
+            case Opcode::F64Store:
+            case Opcode::V128Store: {
+                const Index memory_index = operands.ReadU32();
+                stream.Writef("%s $%" PRIindex ":%%[-2]+$%u, %%[-1]",
+                              opcode.GetName(), memory_index, operands.ReadU32());
+                break;
+            }
+
+            case Opcode::I32AtomicWait:
+            case Opcode::I64AtomicWait:
+            case Opcode::I32AtomicRmwCmpxchg:
+            case Opcode::I64AtomicRmwCmpxchg:
+            case Opcode::I32AtomicRmw8CmpxchgU:
+            case Opcode::I32AtomicRmw16CmpxchgU:
+            case Opcode::I64AtomicRmw8CmpxchgU:
+            case Opcode::I64AtomicRmw16CmpxchgU:
+            case Opcode::I64AtomicRmw32CmpxchgU: {
+                const Index memory_index = operands.ReadU32();
+                stream.Writef("%s $%" PRIindex ":%%[-3]+$%u, %%[-2], %%[-1]",
+                              opcode.GetName(), memory_index, operands.ReadU32());
+                break;
+            }
+
+            case Opcode::I32Add:
+            case Opcode::I32Sub:
+            case Opcode::I32Mul:
+            case Opcode::I32DivS:
+            case Opcode::I32DivU:
+            case Opcode::I32RemS:
+            case Opcode::I32RemU:
+            case Opcode::I32And:
+            case Opcode::I32Or:
+            case Opcode::I32Xor:
+            case Opcode::I32Shl:
+            case Opcode::I32ShrU:
+            case Opcode::I32ShrS:
+            case Opcode::I32Eq:
+            case Opcode::I32Ne:
+            case Opcode::I32LtS:
+            case Opcode::I32LeS:
+            case Opcode::I32LtU:
+            case Opcode::I32LeU:
+            case Opcode::I32GtS:
+            case Opcode::I32GeS:
+            case Opcode::I32GtU:
+            case Opcode::I32GeU:
+            case Opcode::I32Rotr:
+            case Opcode::I32Rotl:
+            case Opcode::F32Add:
+            case Opcode::F32Sub:
+            case Opcode::F32Mul:
+            case Opcode::F32Div:
+            case Opcode::F32Min:
+            case Opcode::F32Max:
+            case Opcode::F32Copysign:
+            case Opcode::F32Eq:
+            case Opcode::F32Ne:
+            case Opcode::F32Lt:
+            case Opcode::F32Le:
+            case Opcode::F32Gt:
+            case Opcode::F32Ge:
+            case Opcode::I64Add:
+            case Opcode::I64Sub:
+            case Opcode::I64Mul:
+            case Opcode::I64DivS:
+            case Opcode::I64DivU:
+            case Opcode::I64RemS:
+            case Opcode::I64RemU:
+            case Opcode::I64And:
+            case Opcode::I64Or:
+            case Opcode::I64Xor:
+            case Opcode::I64Shl:
+            case Opcode::I64ShrU:
+            case Opcode::I64ShrS:
+            case Opcode::I64Eq:
+            case Opcode::I64Ne:
+            case Opcode::I64LtS:
+            case Opcode::I64LeS:
+            case Opcode::I64LtU:
+            case Opcode::I64LeU:
+            case Opcode::I64GtS:
+            case Opcode::I64GeS:
+            case Opcode::I64GtU:
+            case Opcode::I64GeU:
+            case Opcode::I64Rotr:
+            case Opcode::I64Rotl:
+            case Opcode::F64Add:
+            case Opcode::F64Sub:
+            case Opcode::F64Mul:
+            case Opcode::F64Div:
+            case Opcode::F64Min:
+            case Opcode::F64Max:
+            case Opcode::F64Copysign:
+            case Opcode::F64Eq:
+            case Opcode::F64Ne:
+            case Opcode::F64Lt:
+            case Opcode::F64Le:
+            case Opcode::F64Gt:
+            case Opcode::F64Ge:
+            case Opcode::I8X16Add:
+            case Opcode::I16X8Add:
+            case Opcode::I32X4Add:
+            case Opcode::I64X2Add:
+            case Opcode::I8X16Sub:
+            case Opcode::I16X8Sub:
+            case Opcode::I32X4Sub:
+            case Opcode::I64X2Sub:
+            case Opcode::I8X16Mul:
+            case Opcode::I16X8Mul:
+            case Opcode::I32X4Mul:
+            case Opcode::I8X16AddSaturateS:
+            case Opcode::I8X16AddSaturateU:
+            case Opcode::I16X8AddSaturateS:
+            case Opcode::I16X8AddSaturateU:
+            case Opcode::I8X16SubSaturateS:
+            case Opcode::I8X16SubSaturateU:
+            case Opcode::I16X8SubSaturateS:
+            case Opcode::I16X8SubSaturateU:
+            case Opcode::I8X16Shl:
+            case Opcode::I16X8Shl:
+            case Opcode::I32X4Shl:
+            case Opcode::I64X2Shl:
+            case Opcode::I8X16ShrS:
+            case Opcode::I8X16ShrU:
+            case Opcode::I16X8ShrS:
+            case Opcode::I16X8ShrU:
+            case Opcode::I32X4ShrS:
+            case Opcode::I32X4ShrU:
+            case Opcode::I64X2ShrS:
+            case Opcode::I64X2ShrU:
+            case Opcode::V128And:
+            case Opcode::V128Or:
+            case Opcode::V128Xor:
+            case Opcode::I8X16Eq:
+            case Opcode::I16X8Eq:
+            case Opcode::I32X4Eq:
+            case Opcode::F32X4Eq:
+            case Opcode::F64X2Eq:
+            case Opcode::I8X16Ne:
+            case Opcode::I16X8Ne:
+            case Opcode::I32X4Ne:
+            case Opcode::F32X4Ne:
+            case Opcode::F64X2Ne:
+            case Opcode::I8X16LtS:
+            case Opcode::I8X16LtU:
+            case Opcode::I16X8LtS:
+            case Opcode::I16X8LtU:
+            case Opcode::I32X4LtS:
+            case Opcode::I32X4LtU:
+            case Opcode::F32X4Lt:
+            case Opcode::F64X2Lt:
+            case Opcode::I8X16LeS:
+            case Opcode::I8X16LeU:
+            case Opcode::I16X8LeS:
+            case Opcode::I16X8LeU:
+            case Opcode::I32X4LeS:
+            case Opcode::I32X4LeU:
+            case Opcode::F32X4Le:
+            case Opcode::F64X2Le:
+            case Opcode::I8X16GtS:
+            case Opcode::I8X16GtU:
+            case Opcode::I16X8GtS:
+            case Opcode::I16X8GtU:
+            case Opcode::I32X4GtS:
+            case Opcode::I32X4GtU:
+            case Opcode::F32X4Gt:
+            case Opcode::F64X2Gt:
+            case Opcode::I8X16GeS:
+            case Opcode::I8X16GeU:
+            case Opcode::I16X8GeS:
+            case Opcode::I16X8GeU:
+            case Opcode::I32X4GeS:
+            case Opcode::I32X4GeU:
+            case Opcode::F32X4Ge:
+            case Opcode::F64X2Ge:
+            case Opcode::F32X4Min:
+            case Opcode::F64X2Min:
+            case Opcode::F32X4Max:
+            case Opcode::F64X2Max:
+            case Opcode::F32X4Add:
+            case Opcode::F64X2Add:
+            case Opcode::F32X4Sub:
+            case Opcode::F64X2Sub:
+            case Opcode::F32X4Div:
+            case Opcode::F64X2Div:
+            case Opcode::F32X4Mul:
+            case Opcode::F64X2Mul:
+                stream.Writef("%s %%[-2], %%[-1]", opcode.GetName());
+                break;
+
+            case Opcode::I32Clz:
+            case Opcode::I32Ctz:
+            case Opcode::I32Popcnt:
+            case Opcode::I32Eqz:
+            case Opcode::I64Clz:
+            case Opcode::I64Ctz:
+            case Opcode::I64Popcnt:
+            case Opcode::I64Eqz:
+            case Opcode::F32Abs:
+            case Opcode::F32Neg:
+            case Opcode::F32Ceil:
+            case Opcode::F32Floor:
+            case Opcode::F32Trunc:
+            case Opcode::F32Nearest:
+            case Opcode::F32Sqrt:
+            case Opcode::F64Abs:
+            case Opcode::F64Neg:
+            case Opcode::F64Ceil:
+            case Opcode::F64Floor:
+            case Opcode::F64Trunc:
+            case Opcode::F64Nearest:
+            case Opcode::F64Sqrt:
+            case Opcode::I32TruncF32S:
+            case Opcode::I32TruncF32U:
+            case Opcode::I64TruncF32S:
+            case Opcode::I64TruncF32U:
+            case Opcode::F64PromoteF32:
+            case Opcode::I32ReinterpretF32:
+            case Opcode::I32TruncF64S:
+            case Opcode::I32TruncF64U:
+            case Opcode::I64TruncF64S:
+            case Opcode::I64TruncF64U:
+            case Opcode::F32DemoteF64:
+            case Opcode::I64ReinterpretF64:
+            case Opcode::I32WrapI64:
+            case Opcode::F32ConvertI64S:
+            case Opcode::F32ConvertI64U:
+            case Opcode::F64ConvertI64S:
+            case Opcode::F64ConvertI64U:
+            case Opcode::F64ReinterpretI64:
+            case Opcode::I64ExtendI32S:
+            case Opcode::I64ExtendI32U:
+            case Opcode::F32ConvertI32S:
+            case Opcode::F32ConvertI32U:
+            case Opcode::F32ReinterpretI32:
+            case Opcode::F64ConvertI32S:
+            case Opcode::F64ConvertI32U:
+            case Opcode::I32TruncSatF32S:
+            case Opcode::I32TruncSatF32U:
+            case Opcode::I64TruncSatF32S:
+            case Opcode::I64TruncSatF32U:
+            case Opcode::I32TruncSatF64S:
+            case Opcode::I32TruncSatF64U:
+            case Opcode::I64TruncSatF64S:
+            case Opcode::I64TruncSatF64U:
+            case Opcode::I32Extend16S:
+            case Opcode::I32Extend8S:
+            case Opcode::I64Extend16S:
+            case Opcode::I64Extend32S:
+            case Opcode::I64Extend8S:
+            case Opcode::I8X16Splat:
+            case Opcode::I16X8Splat:
+            case Opcode::I32X4Splat:
+            case Opcode::I64X2Splat:
+            case Opcode::F32X4Splat:
+            case Opcode::F64X2Splat:
+            case Opcode::I8X16Neg:
+            case Opcode::I16X8Neg:
+            case Opcode::I32X4Neg:
+            case Opcode::I64X2Neg:
+            case Opcode::V128Not:
+            case Opcode::I8X16AnyTrue:
+            case Opcode::I16X8AnyTrue:
+            case Opcode::I32X4AnyTrue:
+            case Opcode::I64X2AnyTrue:
+            case Opcode::I8X16AllTrue:
+            case Opcode::I16X8AllTrue:
+            case Opcode::I32X4AllTrue:
+            case Opcode::I64X2AllTrue:
+            case Opcode::F32X4Neg:
+            case Opcode::F64X2Neg:
+            case Opcode::F32X4Abs:
+            case Opcode::F64X2Abs:
+            case Opcode::F32X4Sqrt:
+            case Opcode::F64X2Sqrt:
+            case Opcode::F32X4ConvertI32X4S:
+            case Opcode::F32X4ConvertI32X4U:
+            case Opcode::F64X2ConvertI64X2S:
+            case Opcode::F64X2ConvertI64X2U:
+            case Opcode::I32X4TruncSatF32X4S:
+            case Opcode::I32X4TruncSatF32X4U:
+            case Opcode::I64X2TruncSatF64X2S:
+            case Opcode::I64X2TruncSatF64X2U:
+                stream.Writef("%s %%[-1]", opcode.GetName());
+                break;
+
+            case Opcode::I8X16ExtractLaneS:
+            case Opcode::I8X16ExtractLaneU:
+            case Opcode::I16X8ExtractLaneS:
+            case Opcode::I16X8ExtractLaneU:
+            case Opcode::I32X4ExtractLane:
+            case Opcode::I64X2ExtractLane:
+            case Opcode::F32X4ExtractLane:
+            case Opcode::F64X2ExtractLane: {
+                stream.Writef("%s %%[-1] : (Lane imm: %d)", opcode.GetName(),
+                              operands.ReadU8());
+                break;
+            }
+
+            case Opcode::I8X16ReplaceLane:
+            case Opcode::I16X8ReplaceLane:
+            case Opcode::I32X4ReplaceLane:
+            case Opcode::I64X2ReplaceLane:
+            case Opcode::F32X4ReplaceLane:
+            case Opcode::F64X2ReplaceLane: {
+                stream.Writef("%s %%[-1], %%[-2] : (Lane imm: %d)",
+                              opcode.GetName(), operands.ReadU8());
+                break;
+            }
+
+            case Opcode::V8X16Shuffle: {
+                uint32_t lanes[4];
+                for(uint32_t &lane : lanes) {
+                    lane = operands.ReadU32();
+                }
+                stream.Writef(
+                        "%s %%[-2], %%[-1] : (Lane imm: $0x%08x 0x%08x 0x%08x 0x%08x )",
+                        opcode.GetName(), lanes[0], lanes[1], lanes[2], lanes[3]);
+                break;
+            }
+
+            case Opcode::MemoryGrow: {
+                Index memory_index = operands.ReadU32();
+                stream.Writef("%s $%" PRIindex ":%%[-1]", opcode.GetName(),
+                              memory_index);
+                break;
+            }
+
+            case Opcode::InterpAlloca:
+                stream.Writef("%s $%u", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::InterpBrUnless:
+                stream.Writef("%s @%u, %%[-1]", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::InterpDropKeep: {
+                const uint32_t drop = operands.ReadU32();
+                const uint32_t keep = operands.ReadU32();
+                stream.Writef("%s $%u $%u", opcode.GetName(), drop, keep);
+                break;
+            }
+
+            case Opcode::InterpData:
+                stream.Writef("%s $%u ...", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::V128Const: {
+                uint32_t words[4];
+                for(uint32_t &word : words) {
+                    word = operands.ReadU32();
+                }
+                stream.Writef("%s 0x%08x 0x%08x 0x%08x 0x%08x", opcode.GetName(),
+                              words[0], words[1], words[2], words[3]);
+                break;
+            }
+
+            case Opcode::MemoryInit: {
+                const Index memory_index = operands.ReadU32();
+                stream.Writef("%s $%" PRIindex ", $%u, %%[-3], %%[-2], %%[-1]", opcode.GetName(),
+                              memory_index, operands.ReadU32());
+                break;
+            }
+
+            case Opcode::MemoryDrop:
+                WABT_UNREACHABLE;
+                break;
+
+            case Opcode::MemoryCopy:
+            case Opcode::MemoryFill:
+                stream.Writef("%s $%u, %%[-3], %%[-2], %%[-1]", opcode.GetName(), operands.ReadU32());
+                break;
+
+            case Opcode::TableInit:
+                WABT_UNREACHABLE;
+                break;
+
+            case Opcode::TableDrop:
+                WABT_UNREACHABLE;
+                break;
+
+            case Opcode::TableCopy:
+                WABT_UNREACHABLE;
+                break;
+
+                // The following opcodes are either never generated or should never be
+                // executed.
+            case Opcode::Block:
+            case Opcode::Catch:
+            case Opcode::Else:
+            case Opcode::End:
+            case Opcode::If:
+            case Opcode::IfExcept:
+            case Opcode::Invalid:
+            case Opcode::Loop:
+            case Opcode::Rethrow:
+            case Opcode::Throw:
+            case Opcode::Try:
+                WABT_UNREACHABLE;
+                break;
+            default:
+                throw std::runtime_error("Disassembled code for " + std::string(opcode.GetName())
+                                         + " no implemented");
+                break;
+        }
+        return std::string(stream.output_buffer().data.begin(), stream.output_buffer().data.end());
+    }
+
+    bool WdbInstructionDecoder::GetMemoryAccess(const Instruction &instruction, MemoryAccess *access) {
+        using wabt::Opcode;
+        Opcode opcode(instruction.opcode);
+        access->sizeSlot = 0;
+        access->sourceSlot = 0;
+        switch (instruction.opcode) {
+            case Opcode::I32AtomicLoad:
+            case Opcode::I64AtomicLoad:
+            case Opcode::I32AtomicLoad8U:
+            case Opcode::I32AtomicLoad16U:
+            case Opcode::I64AtomicLoad8U:
+            case Opcode::I64AtomicLoad16U:
+            case Opcode::I64AtomicLoad32U:
+            case Opcode::I32Load8S:
+            case Opcode::I32Load8U:
+            case Opcode::I32Load16S:
+            case Opcode::I32Load16U:
+            case Opcode::I64Load8S:
+            case Opcode::I64Load8U:
+            case Opcode::I64Load16S:
+            case Opcode::I64Load16U:
+            case Opcode::I64Load32S:
+            case Opcode::I64Load32U:
+            case Opcode::I32Load:
+            case Opcode::I64Load:
+            case Opcode::F32Load:
+            case Opcode::F64Load:
+            case Opcode::V128Load:
+                access->addressSlot = 1;
+                access->reads = true;
+                access->writes = false;
+                break;
+
+            case Opcode::I32AtomicStore:
+            case Opcode::I64AtomicStore:
+            case Opcode::I32AtomicStore8:
+            case Opcode::I32AtomicStore16:
+            case Opcode::I64AtomicStore8:
+            case Opcode::I64AtomicStore16:
+            case Opcode::I64AtomicStore32:
+            case Opcode::I32Store8:
+            case Opcode::I32Store16:
+            case Opcode::I32Store:
+            case Opcode::I64Store8:
+            case Opcode::I64Store16:
+            case Opcode::I64Store32:
+            case Opcode::I64Store:
+            case Opcode::F32Store:
+            case Opcode::F64Store:
+            case Opcode::V128Store:
+                access->addressSlot = 2;
+                access->reads = false;
+                access->writes = true;
+                break;
+
+            case Opcode::AtomicNotify:
+                access->addressSlot = 2;
+                access->reads = true;
+                access->writes = false;
+                break;
+
+            case Opcode::I32AtomicWait:
+            case Opcode::I64AtomicWait:
+                access->addressSlot = 3;
+                access->reads = true;
+                access->writes = false;
+                break;
+
+            case Opcode::I32AtomicRmwCmpxchg:
+            case Opcode::I64AtomicRmwCmpxchg:
+            case Opcode::I32AtomicRmw8CmpxchgU:
+            case Opcode::I32AtomicRmw16CmpxchgU:
+            case Opcode::I64AtomicRmw8CmpxchgU:
+            case Opcode::I64AtomicRmw16CmpxchgU:
+            case Opcode::I64AtomicRmw32CmpxchgU:
+                access->addressSlot = 3;
+                access->reads = true;
+                access->writes = true;
+                break;
+
+            case Opcode::I32AtomicRmwAdd:
+            case Opcode::I64AtomicRmwAdd:
+            case Opcode::I32AtomicRmw8AddU:
+            case Opcode::I32AtomicRmw16AddU:
+            case Opcode::I64AtomicRmw8AddU:
+            case Opcode::I64AtomicRmw16AddU:
+            case Opcode::I64AtomicRmw32AddU:
+            case Opcode::I32AtomicRmwSub:
+            case Opcode::I64AtomicRmwSub:
+            case Opcode::I32AtomicRmw8SubU:
+            case Opcode::I32AtomicRmw16SubU:
+            case Opcode::I64AtomicRmw8SubU:
+            case Opcode::I64AtomicRmw16SubU:
+            case Opcode::I64AtomicRmw32SubU:
+            case Opcode::I32AtomicRmwAnd:
+            case Opcode::I64AtomicRmwAnd:
+            case Opcode::I32AtomicRmw8AndU:
+            case Opcode::I32AtomicRmw16AndU:
+            case Opcode::I64AtomicRmw8AndU:
+            case Opcode::I64AtomicRmw16AndU:
+            case Opcode::I64AtomicRmw32AndU:
+            case Opcode::I32AtomicRmwOr:
+            case Opcode::I64AtomicRmwOr:
+            case Opcode::I32AtomicRmw8OrU:
+            case Opcode::I32AtomicRmw16OrU:
+            case Opcode::I64AtomicRmw8OrU:
+            case Opcode::I64AtomicRmw16OrU:
+            case Opcode::I64AtomicRmw32OrU:
+            case Opcode::I32AtomicRmwXor:
+            case Opcode::I64AtomicRmwXor:
+            case Opcode::I32AtomicRmw8XorU:
+            case Opcode::I32AtomicRmw16XorU:
+            case Opcode::I64AtomicRmw8XorU:
+            case Opcode::I64AtomicRmw16XorU:
+            case Opcode::I64AtomicRmw32XorU:
+            case Opcode::I32AtomicRmwXchg:
+            case Opcode::I64AtomicRmwXchg:
+            case Opcode::I32AtomicRmw8XchgU:
+            case Opcode::I32AtomicRmw16XchgU:
+            case Opcode::I64AtomicRmw8XchgU:
+            case Opcode::I64AtomicRmw16XchgU:
+            case Opcode::I64AtomicRmw32XchgU:
+                access->addressSlot = 2;
+                access->reads = true;
+                access->writes = true;
+                break;
+
+            // Bulk operations take their operands as (destination, source or value, size)
+            case Opcode::MemoryCopy:
+                access->addressSlot = 3;
+                access->sourceSlot = 2;
+                access->sizeSlot = 1;
+                access->reads = true;
+                access->writes = true;
+                break;
+
+            case Opcode::MemoryFill:
+            case Opcode::MemoryInit:
+                // memory.init reads a data segment, not memory
+                access->addressSlot = 3;
+                access->sizeSlot = 1;
+                access->reads = false;
+                access->writes = true;
+                break;
+
+            default:
+                return false;
+        }
+        access->memoryIndex = static_cast<wabt::Index>(instruction.operands[0]);
+        if(access->sizeSlot != 0) {
+            access->offset = 0;
+            access->size = 0;
+        } else {
+            access->offset = static_cast<uint32_t>(instruction.operands[1]);
+            access->size = static_cast<uint32_t>(opcode.GetMemorySize());
+        }
+        return true;
+    }
+
+    bool WdbInstructionDecoder::MayCallHost(const Instruction &instruction) {
+        return instruction.flow == FLOW_CALL_HOST || instruction.flow == FLOW_CALL_INDIRECT
+               || instruction.flow == FLOW_RETURN_CALL_INDIRECT;
+    }
+
+    bool WdbInstructionDecoder::IsCallOrReturn(const Instruction &instruction) {
+        switch (instruction.flow) {
+            case FLOW_CALL:
+            case FLOW_CALL_INDIRECT:
+            case FLOW_CALL_HOST:
+            case FLOW_RETURN:
+            case FLOW_RETURN_CALL:
+            case FLOW_RETURN_CALL_INDIRECT:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
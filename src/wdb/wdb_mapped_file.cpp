@@ -0,0 +1,61 @@
+#include <wdb/wdb_mapped_file.h>
+#include <wabt/src/common.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace wdb {
+    WdbMappedFile::~WdbMappedFile() {
+        Close();
+    }
+
+    wabt::Result WdbMappedFile::Open(std::string fileName) {
+        Close();
+#ifndef _WIN32
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return wabt::Result::Error;
+        }
+        struct stat fileStat;
+        if(fstat(fd, &fileStat) != 0) {
+            close(fd);
+            return wabt::Result::Error;
+        }
+        m_size = static_cast<size_t>(fileStat.st_size);
+        // Empty files cannot be mapped
+        if(m_size == 0) {
+            close(fd);
+            return wabt::Result::Ok;
+        }
+        void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(data == MAP_FAILED) {
+            m_size = 0;
+            return wabt::Result::Error;
+        }
+        m_data = static_cast<const uint8_t*>(data);
+        m_mapped = true;
+        return wabt::Result::Ok;
+#else
+        wabt::Result result = wabt::ReadFile(fileName, &m_buffer);
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+        return result;
+#endif
+    }
+
+    void WdbMappedFile::Close() {
+#ifndef _WIN32
+        if(m_mapped) {
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+        }
+#endif
+        m_buffer.clear();
+        m_data = nullptr;
+        m_size = 0;
+        m_mapped = false;
+    }
+}
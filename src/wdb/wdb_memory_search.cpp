@@ -0,0 +1,304 @@
+#include <wdb/wdb_memory_search.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <thread>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace wdb {
+    namespace {
+        // Smallest range searched by one thread
+        const size_t kMinThreadRange = 16 * 1024 * 1024;
+        const size_t kVectorSize = 16;
+
+        typedef std::function<void(size_t begin, size_t end, std::vector<uint64_t>* matches)> RangeSearch;
+
+        /**
+         * Get the index of the lowest set bit
+         * @param mask non zero
+         * @return index
+         */
+        inline unsigned CountTrailingZeros(unsigned mask) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned>(index);
+#elif defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+            unsigned index = 0;
+            while(!(mask & 1)) {
+                mask >>= 1;
+                index++;
+            }
+            return index;
+#endif
+        }
+
+        /**
+         * Search a range, split across threads when large enough
+         * @param size
+         * @param alignment split ranges at multiples of alignment
+         * @param options
+         * @param search reports matches starting in [begin, end)
+         * @return sorted matches
+         */
+        std::vector<uint64_t> RunSearch(size_t size, size_t alignment, const WdbMemorySearch::Options &options,
+                                        const RangeSearch &search) {
+            size_t threads = options.threads != 0 ? options.threads
+                                                  : std::max(1u, std::thread::hardware_concurrency());
+            threads = std::min(threads, std::max<size_t>(1, size / kMinThreadRange));
+            std::vector<std::vector<uint64_t>> results(threads);
+            if(threads == 1) {
+                search(0, size, &results[0]);
+            } else {
+                size_t chunk = (size / threads + alignment - 1) / alignment * alignment;
+                std::vector<std::thread> workers;
+                for(size_t i = 0; i < threads; i++) {
+                    size_t begin = std::min(size, i * chunk);
+                    size_t end = i + 1 == threads ? size : std::min(size, begin + chunk);
+                    workers.emplace_back(search, begin, end, &results[i]);
+                }
+                for(auto &worker : workers) {
+                    worker.join();
+                }
+            }
+            // Chunks are in order, concatenate them
+            std::vector<uint64_t> matches = std::move(results[0]);
+            for(size_t i = 1; i < threads && matches.size() < options.maxMatches; i++) {
+                matches.insert(matches.end(), results[i].begin(), results[i].end());
+            }
+            if(matches.size() > options.maxMatches) {
+                matches.resize(options.maxMatches);
+            }
+            return matches;
+        }
+
+        /**
+         * Add a match
+         * @return true if the search is complete
+         */
+        inline bool AddMatch(std::vector<uint64_t> *matches, uint64_t offset, size_t maxMatches) {
+            matches->emplace_back(offset);
+            return matches->size() >= maxMatches;
+        }
+
+        void FindBytesInRange(const uint8_t *data, size_t size, const uint8_t *pattern, size_t patternSize,
+                              size_t begin, size_t end, size_t maxMatches, std::vector<uint64_t> *matches) {
+            if(patternSize == 0 || patternSize > size || maxMatches == 0) {
+                return;
+            }
+            // Matches must fit in the data
+            end = std::min(end, size - patternSize + 1);
+            size_t offset = begin;
+#ifdef __SSE2__
+            // Compare the first and last pattern bytes at 16 offsets at once and verify candidates
+            const __m128i first = _mm_set1_epi8(static_cast<char>(pattern[0]));
+            const __m128i last = _mm_set1_epi8(static_cast<char>(pattern[patternSize - 1]));
+            for(; offset + kVectorSize <= end; offset += kVectorSize) {
+                __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+                __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset + patternSize - 1));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                        _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast))));
+                while(mask) {
+                    size_t candidate = offset + CountTrailingZeros(mask);
+                    if(memcmp(data + candidate, pattern, patternSize) == 0
+                       && AddMatch(matches, candidate, maxMatches)) {
+                        return;
+                    }
+                    mask &= mask - 1;
+                }
+            }
+#endif
+            // Remaining offsets, memchr finds the candidates
+            while(offset < end) {
+                auto hit = static_cast<const uint8_t*>(memchr(data + offset, pattern[0], end - offset));
+                if(!hit) {
+                    break;
+                }
+                offset = hit - data;
+                if(memcmp(hit, pattern, patternSize) == 0 && AddMatch(matches, offset, maxMatches)) {
+                    return;
+                }
+                offset++;
+            }
+        }
+
+        // Kernel testing values one at a time
+        struct ScalarKernel {
+            static const bool kVector = false;
+            unsigned operator()(const uint8_t *block) const { return 0; }
+        };
+
+#ifdef __SSE2__
+        // 32-bit integers within a range, unsigned values are biased to compare as signed
+        struct I32RangeKernel {
+            static const bool kVector = true;
+            __m128i min;
+            __m128i max;
+            __m128i bias;
+
+            I32RangeKernel(uint32_t minBits, uint32_t maxBits, uint32_t biasBits)
+                    : min(_mm_set1_epi32(static_cast<int32_t>(minBits ^ biasBits))),
+                      max(_mm_set1_epi32(static_cast<int32_t>(maxBits ^ biasBits))),
+                      bias(_mm_set1_epi32(static_cast<int32_t>(biasBits))) {}
+
+            unsigned operator()(const uint8_t *block) const {
+                __m128i values = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)), bias);
+                __m128i outside = _mm_or_si128(_mm_cmplt_epi32(values, min), _mm_cmpgt_epi32(values, max));
+                return ~static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(outside))) & 0xF;
+            }
+        };
+
+        // 64-bit integers equal to a value, SSE2 has no 64-bit comparison
+        struct I64EqualKernel {
+            static const bool kVector = true;
+            __m128i value;
+
+            explicit I64EqualKernel(uint64_t bits) : value(_mm_set1_epi64x(static_cast<int64_t>(bits))) {}
+
+            unsigned operator()(const uint8_t *block) const {
+                __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)), value);
+                // Both halves of a lane must be equal
+                equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+                return static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(equal)));
+            }
+        };
+
+        // Floats within a range, NaN never matches
+        struct F32RangeKernel {
+            static const bool kVector = true;
+            __m128 min;
+            __m128 max;
+
+            F32RangeKernel(float minValue, float maxValue) : min(_mm_set1_ps(minValue)), max(_mm_set1_ps(maxValue)) {}
+
+            unsigned operator()(const uint8_t *block) const {
+                __m128 values = _mm_loadu_ps(reinterpret_cast<const float*>(block));
+                return static_cast<unsigned>(_mm_movemask_ps(
+                        _mm_and_ps(_mm_cmpge_ps(values, min), _mm_cmple_ps(values, max))));
+            }
+        };
+
+        struct F64RangeKernel {
+            static const bool kVector = true;
+            __m128d min;
+            __m128d max;
+
+            F64RangeKernel(double minValue, double maxValue) : min(_mm_set1_pd(minValue)), max(_mm_set1_pd(maxValue)) {}
+
+            unsigned operator()(const uint8_t *block) const {
+                __m128d values = _mm_loadu_pd(reinterpret_cast<const double*>(block));
+                return static_cast<unsigned>(_mm_movemask_pd(
+                        _mm_and_pd(_mm_cmpge_pd(values, min), _mm_cmple_pd(values, max))));
+            }
+        };
+#else
+        // Without SSE2 the kernels take the same arguments and leave the values to the scalar loop
+        struct I32RangeKernel : ScalarKernel {
+            I32RangeKernel(uint32_t minBits, uint32_t maxBits, uint32_t biasBits) {}
+        };
+
+        struct I64EqualKernel : ScalarKernel {
+            explicit I64EqualKernel(uint64_t bits) {}
+        };
+
+        struct F32RangeKernel : ScalarKernel {
+            F32RangeKernel(float minValue, float maxValue) {}
+        };
+
+        struct F64RangeKernel : ScalarKernel {
+            F64RangeKernel(double minValue, double maxValue) {}
+        };
+#endif
+
+        /**
+         * Find the aligned values of [begin, end) within [min, max]
+         * @tparam T value type compared by the scalar loop
+         * @tparam Kernel returns the mask of matching lanes in 16 bytes
+         */
+        template <typename T, typename Kernel>
+        void FindValuesInRange(const uint8_t *data, size_t begin, size_t end, T min, T max, const Kernel &kernel,
+                               size_t maxMatches, std::vector<uint64_t> *matches) {
+            if(maxMatches == 0) {
+                return;
+            }
+            size_t offset = begin;
+            if(Kernel::kVector) {
+                for(; offset + kVectorSize <= end; offset += kVectorSize) {
+                    unsigned mask = kernel(data + offset);
+                    while(mask) {
+                        if(AddMatch(matches, offset + CountTrailingZeros(mask) * sizeof(T), maxMatches)) {
+                            return;
+                        }
+                        mask &= mask - 1;
+                    }
+                }
+            }
+            for(; offset + sizeof(T) <= end; offset += sizeof(T)) {
+                T value;
+                memcpy(&value, data + offset, sizeof(T));
+                if(value >= min && value <= max && AddMatch(matches, offset, maxMatches)) {
+                    return;
+                }
+            }
+        }
+
+        template <typename T, typename Kernel>
+        std::vector<uint64_t> FindValues(const uint8_t *data, size_t size, T min, T max, const Kernel &kernel,
+                                         const WdbMemorySearch::Options &options) {
+            // Values must fit in the data
+            size = size / sizeof(T) * sizeof(T);
+            size_t maxMatches = options.maxMatches;
+            return RunSearch(size, sizeof(T), options, [&](size_t begin, size_t end, std::vector<uint64_t> *matches) {
+                FindValuesInRange<T>(data, begin, end, min, max, kernel, maxMatches, matches);
+            });
+        }
+    }
+
+    std::vector<uint64_t> WdbMemorySearch::FindBytes(const uint8_t *data, size_t size, const void *pattern,
+                                                     size_t patternSize, const Options &options) {
+        auto patternBytes = static_cast<const uint8_t*>(pattern);
+        size_t maxMatches = options.maxMatches;
+        return RunSearch(size, 1, options, [&](size_t begin, size_t end, std::vector<uint64_t> *matches) {
+            FindBytesInRange(data, size, patternBytes, patternSize, begin, end, maxMatches, matches);
+        });
+    }
+
+    std::vector<uint64_t> WdbMemorySearch::FindI32(const uint8_t *data, size_t size, uint32_t min, uint32_t max,
+                                                   bool isSigned, const Options &options) {
+        if(isSigned) {
+            return FindValues<int32_t>(data, size, static_cast<int32_t>(min), static_cast<int32_t>(max),
+                                       I32RangeKernel(min, max, 0), options);
+        }
+        return FindValues<uint32_t>(data, size, min, max, I32RangeKernel(min, max, 0x80000000u), options);
+    }
+
+    std::vector<uint64_t> WdbMemorySearch::FindI64(const uint8_t *data, size_t size, uint64_t min, uint64_t max,
+                                                   bool isSigned, const Options &options) {
+        // Only equality is vectorized
+        if(min == max) {
+            return FindValues<uint64_t>(data, size, min, max, I64EqualKernel(min), options);
+        }
+        if(isSigned) {
+            return FindValues<int64_t>(data, size, static_cast<int64_t>(min), static_cast<int64_t>(max),
+                                       ScalarKernel(), options);
+        }
+        return FindValues<uint64_t>(data, size, min, max, ScalarKernel(), options);
+    }
+
+    std::vector<uint64_t> WdbMemorySearch::FindF32(const uint8_t *data, size_t size, float min, float max,
+                                                   const Options &options) {
+        return FindValues<float>(data, size, min, max, F32RangeKernel(min, max), options);
+    }
+
+    std::vector<uint64_t> WdbMemorySearch::FindF64(const uint8_t *data, size_t size, double min, double max,
+                                                   const Options &options) {
+        return FindValues<double>(data, size, min, max, F64RangeKernel(min, max), options);
+    }
+}
@@ -0,0 +1,113 @@
+#include <wdb/wdb_module_cache.h>
+#include <wdb/wdb_mapped_file.h>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace wdb {
+    namespace {
+        const uint32_t kEntryMagic = 0x43424457;
+        // Written in host byte order, reads back differently on a host of the other byte order
+        const uint32_t kByteOrderMark = 0x01020304;
+        const uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+        const uint64_t kFnvPrime = 0x100000001b3ULL;
+
+        // Entry header, followed by the module bytes and the environment image
+        struct EntryHeader {
+            uint32_t magic;
+            uint32_t byteOrderMark;
+            uint64_t moduleHash;
+            uint64_t moduleSize;
+            // The image is checked before its istream is executed
+            uint64_t imageHash;
+            uint64_t imageSize;
+        };
+    }
+
+    uint64_t WdbModuleCache::Hash(const uint8_t *data, size_t size) {
+        // FNV-1a over 64 bit words, then over the remaining bytes
+        uint64_t hash = kFnvOffsetBasis;
+        size_t offset = 0;
+        for(; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, data + offset, sizeof(uint64_t));
+            hash = (hash ^ word) * kFnvPrime;
+        }
+        for(; offset < size; offset++) {
+            hash = (hash ^ data[offset]) * kFnvPrime;
+        }
+        return hash;
+    }
+
+    std::string WdbModuleCache::GetEntryPath(const uint8_t *data, size_t size, wdb::WdbExecutor *executor) const {
+        // Executors with other host functions load the same module from their own entry
+        std::vector<uint8_t> hostPrefix;
+        executor->GetHostPrefix(&hostPrefix);
+        char name[80];
+        snprintf(name, sizeof(name), "%016" PRIx64 "-%" PRIx64 "-%016" PRIx64 ".wdbc", Hash(data, size),
+                 (uint64_t) size, Hash(hostPrefix.data(), hostPrefix.size()));
+        return m_directory + "/" + name;
+    }
+
+    wabt::Result WdbModuleCache::Load(const uint8_t *data, size_t size, wdb::WdbExecutor *executor) {
+        if(!IsEnabled()) {
+            return wabt::Result::Error;
+        }
+        WdbMappedFile entry;
+        if(!wabt::Succeeded(entry.Open(GetEntryPath(data, size, executor))) || entry.GetSize() < sizeof(EntryHeader)) {
+            return wabt::Result::Error;
+        }
+        // Reject foreign files and images saved with another byte order
+        EntryHeader header;
+        memcpy(&header, entry.GetData(), sizeof(EntryHeader));
+        if(header.magic != kEntryMagic || header.byteOrderMark != kByteOrderMark || header.moduleSize != size
+           || entry.GetSize() - sizeof(EntryHeader) < size
+           || header.imageSize != entry.GetSize() - sizeof(EntryHeader) - size) {
+            return wabt::Result::Error;
+        }
+        // The entry name comes from the hash, compare the module bytes to rule out a collision
+        const uint8_t *module = entry.GetData() + sizeof(EntryHeader);
+        if(memcmp(module, data, size) != 0) {
+            return wabt::Result::Error;
+        }
+        // A corrupt image would be executed, it is a miss
+        const uint8_t *image = module + size;
+        if(Hash(image, header.imageSize) != header.imageHash) {
+            return wabt::Result::Error;
+        }
+        return executor->LoadEnvironmentImage(image, header.imageSize);
+    }
+
+    wabt::Result WdbModuleCache::Store(const uint8_t *data, size_t size, wdb::WdbExecutor *executor) {
+        if(!IsEnabled()) {
+            return wabt::Result::Error;
+        }
+        std::vector<uint8_t> image;
+        if(!wabt::Succeeded(executor->SaveEnvironmentImage(&image))) {
+            return wabt::Result::Error;
+        }
+        EntryHeader header;
+        header.magic = kEntryMagic;
+        header.byteOrderMark = kByteOrderMark;
+        header.moduleHash = Hash(data, size);
+        header.moduleSize = size;
+        header.imageHash = Hash(image.data(), image.size());
+        header.imageSize = image.size();
+        // Write a temporary file and rename it so other processes never map a partial entry
+        std::string path = GetEntryPath(data, size, executor);
+        std::string temporaryPath = path + ".tmp" + std::to_string(std::random_device()());
+        FILE *file = fopen(temporaryPath.c_str(), "wb");
+        if(!file) {
+            return wabt::Result::Error;
+        }
+        bool written = fwrite(&header, sizeof(EntryHeader), 1, file) == 1
+                       && fwrite(data, 1, size, file) == size
+                       && fwrite(image.data(), 1, image.size(), file) == image.size();
+        if(fclose(file) != 0 || !written || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            remove(temporaryPath.c_str());
+            return wabt::Result::Error;
+        }
+        return wabt::Result::Ok;
+    }
+}
@@ -0,0 +1,84 @@
+#include <wdb/wdb_output_channel.h>
+#include <wdb/wdb_timer.h>
+#include <algorithm>
+#include <cstring>
+
+namespace wdb {
+    WdbOutputChannel::WdbOutputChannel(size_t capacity) : m_buffer(std::max<size_t>(capacity, 1)),
+                                                          m_flushSize(m_buffer.size()) {}
+
+    WdbOutputChannel::~WdbOutputChannel() {
+        Flush();
+    }
+
+    void WdbOutputChannel::SetFlushInterval(uint32_t microseconds) {
+        m_flushIntervalTicks = (uint64_t) (microseconds * 1000.0 / WdbTimer::GetNanosecondsPerTick());
+        m_lastFlushTicks = WdbTimer::ReadTicks();
+    }
+
+    void WdbOutputChannel::Write(const char *data, size_t size) {
+        const size_t capacity = m_buffer.size();
+        if(m_sink && m_size + size > capacity) {
+            Flush();
+            // Text larger than the buffer goes straight to the sink
+            if(size > capacity) {
+                View view;
+                view.data = data;
+                view.size = size;
+                m_sink(view);
+                return;
+            }
+        }
+        if(size > capacity - m_size) {
+            m_dropped += size - (capacity - m_size);
+            size = capacity - m_size;
+        }
+        // Copy at the end of the ring, wrapping to its start
+        size_t end = (m_start + m_size) % capacity;
+        size_t firstSize = std::min(size, capacity - end);
+        memcpy(m_buffer.data() + end, data, firstSize);
+        memcpy(m_buffer.data(), data + firstSize, size - firstSize);
+        m_size += size;
+        if(m_sink) {
+            if(m_size >= m_flushSize) {
+                Flush();
+            } else if(m_flushIntervalTicks != 0 && WdbTimer::ReadTicks() - m_lastFlushTicks >= m_flushIntervalTicks) {
+                Flush();
+            }
+        }
+    }
+
+    void WdbOutputChannel::Flush() {
+        if(m_flushIntervalTicks != 0) {
+            m_lastFlushTicks = WdbTimer::ReadTicks();
+        }
+        if(!m_sink || m_size == 0) {
+            return;
+        }
+        View first, second;
+        Peek(&first, &second);
+        m_sink(first);
+        if(second.size > 0) {
+            m_sink(second);
+        }
+        Consume(m_size);
+    }
+
+    void WdbOutputChannel::Peek(View *first, View *second) const {
+        const size_t capacity = m_buffer.size();
+        first->data = m_buffer.data() + m_start;
+        first->size = std::min(m_size, capacity - m_start);
+        second->data = m_buffer.data();
+        second->size = m_size - first->size;
+    }
+
+    void WdbOutputChannel::Consume(size_t size) {
+        size = std::min(size, m_size);
+        m_start = (m_start + size) % m_buffer.size();
+        m_size -= size;
+        // Keep writes contiguous when the ring is empty
+        if(m_size == 0) {
+            m_start = 0;
+        }
+    }
+}
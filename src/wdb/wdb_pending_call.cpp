@@ -0,0 +1,57 @@
+#include <wdb/wdb_pending_call.h>
+
+namespace wdb {
+    void WdbPendingCall::Complete(wabt::interp::TypedValues results) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(m_complete) {
+            return;
+        }
+        m_results = std::move(results);
+        Finish(lock);
+    }
+
+    void WdbPendingCall::Fail() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(m_complete) {
+            return;
+        }
+        m_failed = true;
+        Finish(lock);
+    }
+
+    void WdbPendingCall::Finish(std::unique_lock<std::mutex> &lock) {
+        m_complete = true;
+        std::function<void()> handler = std::move(m_completionHandler);
+        lock.unlock();
+        if(handler) {
+            handler();
+        }
+    }
+
+    bool WdbPendingCall::IsComplete() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_complete;
+    }
+
+    bool WdbPendingCall::HasFailed() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_failed;
+    }
+
+    wabt::interp::TypedValues WdbPendingCall::GetResults() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_results;
+    }
+
+    void WdbPendingCall::SetCompletionHandler(std::function<void()> handler) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(!m_complete) {
+            m_completionHandler = std::move(handler);
+            return;
+        }
+        lock.unlock();
+        if(handler) {
+            handler();
+        }
+    }
+}
@@ -1,10 +1,18 @@
 #include <wdb/wdb_profiler_executor.h>
+#include <wdb/wdb_timer.h>
 #include <wabt/src/interp/interp-internal.h>
-#include <chrono>
+#include <algorithm>
 #include <utility>
 
 namespace wdb {
-    WdbProfilerExecutor::WdbProfilerExecutor(wdb::WdbExecutor::Options options) : WdbExecutor(std::move(options)) {}
+    namespace {
+        uint64_t PairKey(uint32_t first, uint32_t second) {
+            return (static_cast<uint64_t>(first) << 32) | second;
+        }
+    }
+
+    WdbProfilerExecutor::WdbProfilerExecutor(wdb::WdbExecutor::Options options) : WdbExecutor(std::move(options)),
+            m_opcodeCounters(static_cast<size_t>(wabt::Opcode::Invalid) + 1) {}
 
     double WdbProfilerExecutor::ProfilerEntry::GetAverageTime() const {
         if(count == 0) {
@@ -36,40 +44,93 @@ namespace wdb {
             }
         };
         // Prepare profiler entries vector
-        std::vector<ProfilerEntry> profilerEntries;
-        for(auto pair : m_profilerMap) {
-            profilerEntries.emplace_back(pair.second);
-        }
+        std::vector<ProfilerEntry> profilerEntries = GetProfilerEntries();
         // Sort entries based on the defined function
         std::sort(profilerEntries.begin(), profilerEntries.end(), sortingFunction);
         return profilerEntries;
     }
 
+    std::map<wabt::Opcode, WdbProfilerExecutor::ProfilerEntry> WdbProfilerExecutor::GetProfilerMap() const {
+        std::map<wabt::Opcode, ProfilerEntry> profilerMap;
+        for(auto &entry : GetProfilerEntries()) {
+            profilerMap[entry.opcode] = entry;
+        }
+        return profilerMap;
+    }
+
+    std::vector<WdbProfilerExecutor::ProfilerEntry> WdbProfilerExecutor::GetProfilerEntries() const {
+        std::vector<ProfilerEntry> profilerEntries;
+        double nanosecondsPerTick = WdbTimer::GetNanosecondsPerTick();
+        for(size_t i = 0; i < m_opcodeCounters.size(); i++) {
+            const OpcodeCounter &counter = m_opcodeCounters[i];
+            if(counter.count == 0) {
+                continue;
+            }
+            ProfilerEntry entry;
+            entry.opcode = static_cast<wabt::Opcode::Enum>(i);
+            entry.count = counter.count;
+            // Scale the timed instructions up to all executed ones
+            if(counter.timedCount > 0) {
+                entry.totalTime = (long) (counter.timedTicks * nanosecondsPerTick * counter.count / counter.timedCount);
+            }
+            profilerEntries.emplace_back(entry);
+        }
+        return profilerEntries;
+    }
+
     wabt::Result WdbProfilerExecutor::Execute() {
+        if(m_mode == FUNCTION_MODE) {
+            return ExecuteFunctions();
+        }
+        return ExecuteOpcodes();
+    }
+
+    wabt::Result WdbProfilerExecutor::ExecuteOpcodes() {
         if (CanRun()) {
+            // Straight-line runs end at the first instruction that does not fall through
+            if(!m_blockMap.IsBuilt(m_env) && wabt::Succeeded(m_blockMap.Build(m_env))) {
+                m_blockMap.SetStops([](const WdbInstructionDecoder::Instruction &instruction) {
+                    return instruction.flow != WdbInstructionDecoder::FLOW_NEXT;
+                });
+            }
+            const bool useRuns = m_blockMap.IsBuilt(m_env);
             wabt::interp::Result result = wabt::interp::Result::Ok;
+            const uint8_t *istream = m_env->istream().data.data();
+            const uint64_t overhead = WdbTimer::GetReadOverhead();
+            // Instructions left before the next timed one
+            uint64_t untilTiming = 0;
             // Keep executing instructions
             while (result == wabt::interp::Result::Ok) {
-                // Create a temp pc
-                const uint8_t *istream = m_env->istream().data.data();
-                const uint8_t *tmpPc = &istream[m_thread->pc()];
+                wabt::interp::IstreamOffset pc = m_thread->pc();
+                if(useRuns && untilTiming > 0) {
+                    // Run up to the end of the straight line or the timed instruction, the opcodes
+                    // of the run are counted from its decoded instructions once the execution stops
+                    uint64_t length = std::min<uint64_t>(static_cast<uint64_t>(m_blockMap.GetRunLength(pc)) + 1,
+                                                         untilTiming);
+                    length = std::max<uint64_t>(1, std::min(length, GetFuel()));
+                    result = RunInstructions(static_cast<int>(length));
+                    m_runCounts[PairKey(pc, static_cast<uint32_t>(length))]++;
+                    untilTiming -= length;
+                    continue;
+                }
                 // Fetch opcode at this pc
-                wabt::Opcode opcode = wabt::interp::ReadOpcode(&tmpPc);
-                // Start measuring the execution time
-                std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
-                // Run next instruction
-                result = m_thread->Run(1);
-                // Record the execution time
-                std::chrono::high_resolution_clock::time_point endTime = std::chrono::high_resolution_clock::now();
-                // Create entry if not already created
-                if (m_profilerMap.find(opcode) == m_profilerMap.end()) {
-                    m_profilerMap[opcode] = ProfilerEntry();
-                    m_profilerMap[opcode].opcode = opcode;
+                const uint8_t *tmpPc = &istream[pc];
+                OpcodeCounter &counter = m_opcodeCounters[wabt::interp::ReadOpcode(&tmpPc)];
+                counter.count++;
+                if (untilTiming > 0) {
+                    untilTiming--;
+                    result = RunInstructions(1);
+                    continue;
                 }
-                m_profilerMap[opcode].count++;
-                m_profilerMap[opcode].totalTime +=
-                        std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+                untilTiming = m_timingInterval - 1;
+                // Measure the execution time without the cost of reading the timer
+                uint64_t startTicks = WdbTimer::ReadTicks();
+                result = RunInstructions(1);
+                uint64_t ticks = WdbTimer::ReadTicks() - startTicks;
+                counter.timedCount++;
+                counter.timedTicks += ticks > overhead ? ticks - overhead : 0;
             }
+            FlushRunCounts();
             // Main function has returned
             if (result == wabt::interp::Result::Returned) {
                 SetMainFunctionReturned();
@@ -78,4 +139,173 @@ namespace wdb {
         }
         return wabt::Result::Error;
     }
+
+    void WdbProfilerExecutor::FlushRunCounts() {
+        // Static opcode histogram of each run times its executions
+        for(auto &pair : m_runCounts) {
+            wabt::interp::IstreamOffset offset = static_cast<wabt::interp::IstreamOffset>(pair.first >> 32);
+            uint32_t length = static_cast<uint32_t>(pair.first);
+            for(uint32_t i = 0; i < length; i++) {
+                const WdbInstructionDecoder::Instruction *instruction = m_blockMap.GetInstruction(offset);
+                if(!instruction) {
+                    break;
+                }
+                m_opcodeCounters[static_cast<size_t>(instruction->opcode)].count += pair.second;
+                offset += instruction->length;
+            }
+        }
+        m_runCounts.clear();
+    }
+
+    wabt::Result WdbProfilerExecutor::ExecuteFunctions() {
+        if (CanRun()) {
+            // Stop at every instruction entering or leaving a function
+            if(!m_callMap.IsBuilt(m_env)) {
+                if(!wabt::Succeeded(m_callMap.Build(m_env))) {
+                    return wabt::Result::Error;
+                }
+                m_callMap.SetStops(WdbInstructionDecoder::IsCallOrReturn);
+            }
+            if(m_functionCounters.size() < m_env->GetFuncCount()) {
+                m_functionCounters.resize(m_env->GetFuncCount());
+            }
+            // Enter main function
+            if(m_frames.empty()) {
+                EnterFunction(GetFunctionAt(m_thread->pc()), WdbTimer::ReadTicks());
+            }
+            wabt::interp::Result result = wabt::interp::Result::Ok;
+            while (result == wabt::interp::Result::Ok) {
+                wabt::interp::IstreamOffset pc = m_thread->pc();
+                // Run in batches between calls and returns
+                if(!m_callMap.IsStop(pc)) {
+                    result = RunInstructions(m_callMap.GetRunLength(pc));
+                    continue;
+                }
+                const WdbInstructionDecoder::Instruction *instruction = m_callMap.GetInstruction(pc);
+                // An indirect call to a host function runs it in place without entering a body
+                const bool hostCallee = instruction->flow != WdbInstructionDecoder::FLOW_CALL_HOST
+                                        && IsHostCall(*instruction);
+                const wabt::Index callee = hostCallee ? GetIndirectCallee(*instruction) : wabt::kInvalidIndex;
+                uint64_t startTicks = WdbTimer::ReadTicks();
+                result = RunInstructions(1);
+                uint64_t endTicks = WdbTimer::ReadTicks();
+                if(result != wabt::interp::Result::Ok && result != wabt::interp::Result::Returned) {
+                    break;
+                }
+                switch (instruction->flow) {
+                    case WdbInstructionDecoder::FLOW_CALL_HOST:
+                        EnterFunction(instruction->target, startTicks);
+                        LeaveFunction(endTicks);
+                        break;
+                    case WdbInstructionDecoder::FLOW_CALL:
+                        EnterFunction(GetFunctionAt(m_thread->pc()), endTicks);
+                        break;
+                    case WdbInstructionDecoder::FLOW_CALL_INDIRECT:
+                        if(hostCallee) {
+                            EnterFunction(callee, startTicks);
+                            LeaveFunction(endTicks);
+                        } else {
+                            EnterFunction(GetFunctionAt(m_thread->pc()), endTicks);
+                        }
+                        break;
+                    case WdbInstructionDecoder::FLOW_RETURN_CALL:
+                        LeaveFunction(endTicks);
+                        EnterFunction(GetFunctionAt(m_thread->pc()), endTicks);
+                        break;
+                    case WdbInstructionDecoder::FLOW_RETURN_CALL_INDIRECT:
+                        if(hostCallee) {
+                            // The host function runs, then the current function returns
+                            EnterFunction(callee, startTicks);
+                            LeaveFunction(endTicks);
+                            LeaveFunction(endTicks);
+                        } else {
+                            LeaveFunction(endTicks);
+                            EnterFunction(GetFunctionAt(m_thread->pc()), endTicks);
+                        }
+                        break;
+                    default:
+                        LeaveFunction(endTicks);
+                        break;
+                }
+            }
+            // Main function has returned
+            if (result == wabt::interp::Result::Returned) {
+                SetMainFunctionReturned();
+                return wabt::Result::Ok;
+            }
+        }
+        return wabt::Result::Error;
+    }
+
+    void WdbProfilerExecutor::EnterFunction(wabt::Index function, uint64_t ticks) {
+        uint32_t parent = WdbCallTree::kNoNode;
+        if(!m_frames.empty()) {
+            parent = m_frames.back().node;
+            m_callEdges[PairKey(m_frames.back().function, function)]++;
+        }
+        uint32_t node = m_callTree.GetChild(parent, function);
+        if(function >= m_functionCounters.size()) {
+            m_functionCounters.resize(function + 1);
+        }
+        m_functionCounters[function].count++;
+        m_functionCounters[function].active++;
+        m_frames.push_back({function, node, ticks, 0});
+    }
+
+    void WdbProfilerExecutor::LeaveFunction(uint64_t ticks) {
+        if(m_frames.empty()) {
+            return;
+        }
+        Frame frame = m_frames.back();
+        m_frames.pop_back();
+        uint64_t inclusiveTicks = ticks - frame.startTicks;
+        uint64_t exclusiveTicks = inclusiveTicks > frame.childTicks ? inclusiveTicks - frame.childTicks : 0;
+        FunctionCounter &counter = m_functionCounters[frame.function];
+        counter.exclusiveTicks += exclusiveTicks;
+        // Count inclusive time of recursive calls only once
+        if(--counter.active == 0) {
+            counter.inclusiveTicks += inclusiveTicks;
+        }
+        m_callTree.AddValue(frame.node, exclusiveTicks);
+        if(!m_frames.empty()) {
+            m_frames.back().childTicks += inclusiveTicks;
+        }
+    }
+
+    std::vector<WdbProfilerExecutor::FunctionEntry> WdbProfilerExecutor::GetFunctionProfile() {
+        std::vector<FunctionEntry> functionEntries;
+        double nanosecondsPerTick = WdbTimer::GetNanosecondsPerTick();
+        for(wabt::Index i = 0; i < m_functionCounters.size(); i++) {
+            const FunctionCounter &counter = m_functionCounters[i];
+            if(counter.count == 0) {
+                continue;
+            }
+            FunctionEntry entry;
+            entry.function = i;
+            entry.name = GetFunctionName(i);
+            entry.count = counter.count;
+            entry.inclusiveTime = (long) (counter.inclusiveTicks * nanosecondsPerTick);
+            entry.exclusiveTime = (long) (counter.exclusiveTicks * nanosecondsPerTick);
+            functionEntries.emplace_back(entry);
+        }
+        return functionEntries;
+    }
+
+    std::vector<WdbProfilerExecutor::CallEdge> WdbProfilerExecutor::GetCallEdges() const {
+        std::vector<CallEdge> callEdges;
+        for(auto &pair : m_callEdges) {
+            CallEdge edge;
+            edge.caller = static_cast<wabt::Index>(pair.first >> 32);
+            edge.callee = static_cast<wabt::Index>(pair.first);
+            edge.count = pair.second;
+            callEdges.emplace_back(edge);
+        }
+        return callEdges;
+    }
+
+    std::string WdbProfilerExecutor::GetFoldedStacks() {
+        return m_callTree.GetFoldedStacks([&](wabt::Index function) {
+            return GetFunctionName(function);
+        }, WdbTimer::GetNanosecondsPerTick());
+    }
 }
\ No newline at end of file
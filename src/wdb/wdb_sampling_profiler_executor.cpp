@@ -0,0 +1,191 @@
+#include <wdb/wdb_sampling_profiler_executor.h>
+#include <wdb/wdb_timer.h>
+#include <algorithm>
+#include <set>
+#include <utility>
+
+namespace wdb {
+    namespace {
+        // Instructions run between two clock reads with the timer trigger
+        const int kTimerCheckInstructions = 1000;
+    }
+
+    WdbSamplingProfilerExecutor::WdbSamplingProfilerExecutor(wdb::WdbExecutor::Options options)
+            : WdbExecutor(std::move(options)) {}
+
+    void WdbSamplingProfilerExecutor::SetInstructionInterval(uint32_t instructions) {
+        m_trigger = INSTRUCTION_TRIGGER;
+        m_instructionInterval = instructions > 0 ? instructions : 1;
+        m_untilSample = 0;
+    }
+
+    void WdbSamplingProfilerExecutor::SetTimerInterval(uint32_t microseconds) {
+        m_trigger = TIMER_TRIGGER;
+        m_timerIntervalTicks = (uint64_t) (microseconds * 1000.0 / WdbTimer::GetNanosecondsPerTick());
+        m_nextSampleTicks = 0;
+    }
+
+    wabt::Result WdbSamplingProfilerExecutor::Execute() {
+        if (CanRun()) {
+            // Stop at every instruction entering or leaving a function
+            if(m_recordCallStacks) {
+                if(!m_callMap.IsBuilt(m_env)) {
+                    if(!wabt::Succeeded(m_callMap.Build(m_env))) {
+                        return wabt::Result::Error;
+                    }
+                    m_callMap.SetStops(WdbInstructionDecoder::IsCallOrReturn);
+                }
+                if(m_frames.empty()) {
+                    m_frames.emplace_back(m_callTree.GetChild(WdbCallTree::kNoNode, GetFunctionAt(m_thread->pc())));
+                }
+            }
+            // Start sampling
+            if(m_untilSample == 0) {
+                m_untilSample = m_instructionInterval;
+            }
+            if(m_nextSampleTicks == 0) {
+                m_nextSampleTicks = WdbTimer::ReadTicks() + m_timerIntervalTicks;
+            }
+            wabt::interp::Result result = wabt::interp::Result::Ok;
+            while (result == wabt::interp::Result::Ok) {
+                wabt::interp::IstreamOffset pc = m_thread->pc();
+                int executed;
+                if(m_recordCallStacks && m_callMap.IsStop(pc)) {
+                    // Run the call or return alone to follow the call stack
+                    const WdbInstructionDecoder::Instruction *instruction = m_callMap.GetInstruction(pc);
+                    const bool hostCallee = IsHostCall(*instruction);
+                    result = RunInstructions(1);
+                    if(result == wabt::interp::Result::Ok) {
+                        UpdateCallStack(*instruction, hostCallee);
+                    }
+                    executed = 1;
+                } else {
+                    // Run until the next sample or the next call or return
+                    executed = m_trigger == INSTRUCTION_TRIGGER ? static_cast<int>(m_untilSample)
+                                                                : kTimerCheckInstructions;
+                    if(m_recordCallStacks) {
+                        executed = std::min(executed, m_callMap.GetRunLength(pc));
+                    }
+                    result = RunInstructions(executed);
+                }
+                if(result != wabt::interp::Result::Ok) {
+                    break;
+                }
+                // Check sampling trigger
+                if(m_trigger == INSTRUCTION_TRIGGER) {
+                    m_untilSample -= executed;
+                    if(m_untilSample == 0) {
+                        TakeSample();
+                        m_untilSample = m_instructionInterval;
+                    }
+                } else {
+                    uint64_t ticks = WdbTimer::ReadTicks();
+                    if(ticks >= m_nextSampleTicks) {
+                        TakeSample();
+                        m_nextSampleTicks = ticks + m_timerIntervalTicks;
+                    }
+                }
+            }
+            // Main function has returned
+            if (result == wabt::interp::Result::Returned) {
+                SetMainFunctionReturned();
+                return wabt::Result::Ok;
+            }
+        }
+        return wabt::Result::Error;
+    }
+
+    void WdbSamplingProfilerExecutor::UpdateCallStack(const WdbInstructionDecoder::Instruction &instruction,
+                                                      bool hostCallee) {
+        // A host function runs in place, a host function reached by a tail call also returns
+        if(hostCallee) {
+            if(instruction.flow == WdbInstructionDecoder::FLOW_RETURN_CALL_INDIRECT && m_frames.size() > 1) {
+                m_frames.pop_back();
+            }
+            return;
+        }
+        switch (instruction.flow) {
+            case WdbInstructionDecoder::FLOW_CALL:
+            case WdbInstructionDecoder::FLOW_CALL_INDIRECT:
+                m_frames.emplace_back(m_callTree.GetChild(m_frames.back(), GetFunctionAt(m_thread->pc())));
+                break;
+            case WdbInstructionDecoder::FLOW_RETURN_CALL:
+            case WdbInstructionDecoder::FLOW_RETURN_CALL_INDIRECT:
+                m_frames.back() = m_callTree.GetChild(m_callTree.GetParent(m_frames.back()),
+                                                      GetFunctionAt(m_thread->pc()));
+                break;
+            case WdbInstructionDecoder::FLOW_RETURN:
+                if(m_frames.size() > 1) {
+                    m_frames.pop_back();
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    void WdbSamplingProfilerExecutor::TakeSample() {
+        m_sampleCount++;
+        m_pcSamples[m_thread->pc()]++;
+        if(m_recordCallStacks && !m_frames.empty()) {
+            m_callTree.AddValue(m_frames.back(), 1);
+        }
+    }
+
+    std::vector<WdbSamplingProfilerExecutor::PcSample> WdbSamplingProfilerExecutor::GetPcSamples() {
+        std::vector<PcSample> pcSamples;
+        for(auto &pair : m_pcSamples) {
+            PcSample sample;
+            sample.pc = pair.first;
+            sample.function = GetFunctionAt(pair.first);
+            sample.count = pair.second;
+            pcSamples.emplace_back(sample);
+        }
+        std::sort(pcSamples.begin(), pcSamples.end(), [](PcSample const &a, PcSample const &b) {
+            return a.count > b.count;
+        });
+        return pcSamples;
+    }
+
+    std::vector<WdbSamplingProfilerExecutor::FunctionSample> WdbSamplingProfilerExecutor::GetFunctionSamples() {
+        std::map<wabt::Index, FunctionSample> functionSamples;
+        // Self samples come from the sampled pc
+        for(auto &pair : m_pcSamples) {
+            wabt::Index function = GetFunctionAt(pair.first);
+            functionSamples[function].function = function;
+            functionSamples[function].selfCount += pair.second;
+        }
+        // Total samples count every function of a sampled stack once
+        std::set<wabt::Index> stackFunctions;
+        for(uint32_t i = 0; i < m_callTree.GetNodeCount(); i++) {
+            if(m_callTree.GetValue(i) == 0) {
+                continue;
+            }
+            stackFunctions.clear();
+            for(uint32_t node = i; node != WdbCallTree::kNoNode; node = m_callTree.GetParent(node)) {
+                stackFunctions.insert(m_callTree.GetFunction(node));
+            }
+            for(wabt::Index function : stackFunctions) {
+                functionSamples[function].function = function;
+                functionSamples[function].totalCount += m_callTree.GetValue(i);
+            }
+        }
+        std::vector<FunctionSample> result;
+        for(auto &pair : functionSamples) {
+            if(pair.first != wabt::kInvalidIndex) {
+                pair.second.name = GetFunctionName(pair.first);
+            }
+            result.emplace_back(pair.second);
+        }
+        std::sort(result.begin(), result.end(), [](FunctionSample const &a, FunctionSample const &b) {
+            return a.selfCount > b.selfCount;
+        });
+        return result;
+    }
+
+    std::string WdbSamplingProfilerExecutor::GetFoldedStacks() {
+        return m_callTree.GetFoldedStacks([&](wabt::Index function) {
+            return GetFunctionName(function);
+        });
+    }
+}
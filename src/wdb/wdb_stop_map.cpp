@@ -0,0 +1,174 @@
+#include <wdb/wdb_stop_map.h>
+#include <wabt/src/cast.h>
+#include <climits>
+#include <deque>
+
+namespace wdb {
+    namespace {
+        const uint32_t kNoIndex = UINT32_MAX;
+        const uint32_t kUnreachable = UINT32_MAX;
+    }
+
+    wabt::Result WdbStopMap::Build(wabt::interp::Environment *env) {
+        using namespace wabt::interp;
+        // Reset previous graph
+        m_env = nullptr;
+        m_istreamSize = 0;
+        m_instructions.clear();
+        m_predecessorStart.clear();
+        m_predecessors.clear();
+        m_distance.clear();
+        const std::vector<uint8_t> &istream = env->istream().data;
+        WdbInstructionDecoder decoder(istream.data(), istream.size());
+        m_indexAt.assign(istream.size(), kNoIndex);
+        // Decode every instruction
+        IstreamOffset offset = 0;
+        while(offset < istream.size()) {
+            WdbInstructionDecoder::Instruction instruction;
+            if(!wabt::Succeeded(decoder.Decode(offset, &instruction))) {
+                m_instructions.clear();
+                m_indexAt.clear();
+                return wabt::Result::Error;
+            }
+            m_indexAt[offset] = static_cast<uint32_t>(m_instructions.size());
+            m_instructions.emplace_back(instruction);
+            offset += instruction.length;
+        }
+        // Virtual nodes standing for any function entry and any return site
+        const uint32_t count = static_cast<uint32_t>(m_instructions.size());
+        const uint32_t anyEntry = count;
+        const uint32_t anyReturnSite = count + 1;
+        const uint32_t nodeCount = count + 2;
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+        auto addEdge = [&](uint32_t from, IstreamOffset to) {
+            if(to < m_indexAt.size() && m_indexAt[to] != kNoIndex) {
+                edges.emplace_back(from, m_indexAt[to]);
+            }
+        };
+        // Collect the successors of every instruction
+        for(uint32_t i = 0; i < count; i++) {
+            const WdbInstructionDecoder::Instruction &instruction = m_instructions[i];
+            IstreamOffset next = instruction.offset + instruction.length;
+            switch (instruction.flow) {
+                case WdbInstructionDecoder::FLOW_NEXT:
+                case WdbInstructionDecoder::FLOW_CALL_HOST:
+                    addEdge(i, next);
+                    break;
+                case WdbInstructionDecoder::FLOW_BRANCH:
+                case WdbInstructionDecoder::FLOW_RETURN_CALL:
+                    addEdge(i, instruction.target);
+                    break;
+                case WdbInstructionDecoder::FLOW_BRANCH_IF:
+                    addEdge(i, instruction.target);
+                    addEdge(i, next);
+                    break;
+                case WdbInstructionDecoder::FLOW_BRANCH_TABLE:
+                    for(wabt::Index entry = 0; entry < instruction.tableSize; entry++) {
+                        addEdge(i, decoder.GetTableTarget(instruction, entry));
+                    }
+                    break;
+                case WdbInstructionDecoder::FLOW_CALL:
+                    addEdge(i, instruction.target);
+                    addEdge(anyReturnSite, next);
+                    break;
+                case WdbInstructionDecoder::FLOW_CALL_INDIRECT:
+                    // A host function in the table is called in place
+                    edges.emplace_back(i, anyEntry);
+                    addEdge(i, next);
+                    addEdge(anyReturnSite, next);
+                    break;
+                case WdbInstructionDecoder::FLOW_RETURN_CALL_INDIRECT:
+                    // A host function in the table is called, then the current function returns
+                    edges.emplace_back(i, anyEntry);
+                    edges.emplace_back(i, anyReturnSite);
+                    break;
+                case WdbInstructionDecoder::FLOW_RETURN:
+                    edges.emplace_back(i, anyReturnSite);
+                    break;
+                case WdbInstructionDecoder::FLOW_TRAP:
+                case WdbInstructionDecoder::FLOW_DATA:
+                    break;
+            }
+        }
+        // Indirect calls may enter any defined function
+        for(wabt::Index i = 0; i < env->GetFuncCount(); i++) {
+            Func *func = env->GetFunc(i);
+            if(!func->is_host) {
+                addEdge(anyEntry, wabt::cast<DefinedFunc>(func)->offset);
+            }
+        }
+        // Store predecessors in compressed sparse row form
+        m_predecessorStart.assign(nodeCount + 1, 0);
+        for(auto &edge : edges) {
+            m_predecessorStart[edge.second + 1]++;
+        }
+        for(uint32_t i = 0; i < nodeCount; i++) {
+            m_predecessorStart[i + 1] += m_predecessorStart[i];
+        }
+        m_predecessors.resize(edges.size());
+        std::vector<uint32_t> fill(m_predecessorStart.begin(), m_predecessorStart.end() - 1);
+        for(auto &edge : edges) {
+            m_predecessors[fill[edge.second]++] = edge.first;
+        }
+        m_env = env;
+        m_istreamSize = istream.size();
+        return wabt::Result::Ok;
+    }
+
+    bool WdbStopMap::IsBuilt(wabt::interp::Environment *env) const {
+        return m_env == env && m_istreamSize == env->istream().data.size();
+    }
+
+    void WdbStopMap::SetStops(std::function<bool(const WdbInstructionDecoder::Instruction &)> isStop) {
+        const uint32_t count = static_cast<uint32_t>(m_instructions.size());
+        m_distance.assign(m_predecessorStart.empty() ? 0 : m_predecessorStart.size() - 1, kUnreachable);
+        std::deque<uint32_t> queue;
+        for(uint32_t i = 0; i < count; i++) {
+            if(isStop(m_instructions[i])) {
+                m_distance[i] = 0;
+                queue.push_back(i);
+            }
+        }
+        // Walk the graph backwards from the stops, edges leaving virtual nodes cost no instruction
+        while(!queue.empty()) {
+            uint32_t node = queue.front();
+            queue.pop_front();
+            for(uint32_t i = m_predecessorStart[node]; i < m_predecessorStart[node + 1]; i++) {
+                uint32_t predecessor = m_predecessors[i];
+                uint32_t weight = predecessor >= count ? 0 : 1;
+                uint32_t distance = m_distance[node] + weight;
+                if(distance < m_distance[predecessor]) {
+                    m_distance[predecessor] = distance;
+                    if(weight == 0) {
+                        queue.push_front(predecessor);
+                    } else {
+                        queue.push_back(predecessor);
+                    }
+                }
+            }
+        }
+    }
+
+    bool WdbStopMap::IsStop(wabt::interp::IstreamOffset offset) const {
+        if(offset >= m_indexAt.size() || m_indexAt[offset] == kNoIndex || m_distance.empty()) {
+            return false;
+        }
+        return m_distance[m_indexAt[offset]] == 0;
+    }
+
+    const WdbInstructionDecoder::Instruction* WdbStopMap::GetInstruction(wabt::interp::IstreamOffset offset) const {
+        if(offset >= m_indexAt.size() || m_indexAt[offset] == kNoIndex) {
+            return nullptr;
+        }
+        return &m_instructions[m_indexAt[offset]];
+    }
+
+    int WdbStopMap::GetRunLength(wabt::interp::IstreamOffset offset) const {
+        // Unknown offsets can only be stepped
+        if(offset >= m_indexAt.size() || m_indexAt[offset] == kNoIndex || m_distance.empty()) {
+            return 1;
+        }
+        uint32_t distance = m_distance[m_indexAt[offset]];
+        return distance >= static_cast<uint32_t>(INT_MAX) ? INT_MAX : static_cast<int>(distance);
+    }
+}
@@ -0,0 +1,52 @@
+#include <wdb/wdb_timer.h>
+#include <algorithm>
+#include <vector>
+
+namespace wdb {
+    namespace {
+        const int kCalibrationMicroseconds = 5000;
+        const int kOverheadSamples = 1001;
+
+        double CalibrateNanosecondsPerTick() {
+#ifdef WDB_TIMER_TSC
+            // Compare the timestamp counter against the steady clock over a short busy wait
+            auto startTime = std::chrono::steady_clock::now();
+            uint64_t startTicks = WdbTimer::ReadTicks();
+            auto endTime = startTime;
+            while (endTime - startTime < std::chrono::microseconds(kCalibrationMicroseconds)) {
+                endTime = std::chrono::steady_clock::now();
+            }
+            uint64_t endTicks = WdbTimer::ReadTicks();
+            if(endTicks <= startTicks) {
+                return 1;
+            }
+            return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count()
+                   / (endTicks - startTicks);
+#else
+            return 1;
+#endif
+        }
+
+        uint64_t CalibrateReadOverhead() {
+            // Use the median of back to back reads
+            std::vector<uint64_t> samples(kOverheadSamples);
+            for(auto &sample : samples) {
+                uint64_t start = WdbTimer::ReadTicks();
+                uint64_t end = WdbTimer::ReadTicks();
+                sample = end - start;
+            }
+            std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+            return samples[samples.size() / 2];
+        }
+    }
+
+    double WdbTimer::GetNanosecondsPerTick() {
+        static const double nanosecondsPerTick = CalibrateNanosecondsPerTick();
+        return nanosecondsPerTick;
+    }
+
+    uint64_t WdbTimer::GetReadOverhead() {
+        static const uint64_t overhead = CalibrateReadOverhead();
+        return overhead;
+    }
+}
@@ -5,11 +5,23 @@
 #include <wabt/src/interp/interp-internal.h>
 
 namespace wdb {
+    WdbWabt::~WdbWabt() {
+        delete m_preparedExecutor;
+    }
+
     wabt::Result WdbWabt::LoadModuleFile(std::string fileName) {
+        // Forget the previously loaded module
+        WdbExecutor *prepared;
+        {
+            std::lock_guard<std::mutex> lock(m_preparedMutex);
+            prepared = m_preparedExecutor;
+            m_preparedExecutor = nullptr;
+        }
+        delete prepared;
         // Set file name
         m_fileName = fileName;
-        // Read file data
-        return wabt::ReadFile(fileName, &m_fileData);
+        // Map file data
+        return m_file.Open(fileName);
     }
 
     wdb::WdbExecutor* WdbWabt::CreateWdbExecutor(wdb::WdbExecutor::Options options) {
@@ -39,9 +51,18 @@ namespace wdb {
         return nullptr;
     }
 
+    wdb::WdbSamplingProfilerExecutor* WdbWabt::CreateWdbSamplingProfilerExecutor(wdb::WdbExecutor::Options options) {
+        auto executor = new WdbSamplingProfilerExecutor(options);
+        if(wabt::Succeeded(ConfigureExecutor(executor, options))) {
+            return executor;
+        }
+        delete executor;
+        return nullptr;
+    }
+
     wdb::WdbCodeGen* WdbWabt::CreateCodeGenerator() {
         auto codeGenerator = new WdbCodeGen();
-        if(wabt::Succeeded(codeGenerator->SetupCode(&m_fileData))) {
+        if(wabt::Succeeded(codeGenerator->SetupCode(m_file.GetData(), m_file.GetSize()))) {
             return codeGenerator;
         }
         delete codeGenerator;
@@ -49,8 +70,36 @@ namespace wdb {
     }
 
     wabt::Result WdbWabt::ConfigureExecutor(wdb::WdbExecutor *executor, wdb::WdbExecutor::Options options) {
-        if(!wabt::Succeeded(executor->SetupEnvironment(&m_fileData))) {
-            return wabt::Result::Error;
+        // The prepared executor is never modified once set, so it is cloned without the lock
+        WdbExecutor *prepared;
+        {
+            std::lock_guard<std::mutex> lock(m_preparedMutex);
+            prepared = m_preparedExecutor;
+        }
+        // Clone the module prepared by a previous executor, otherwise load it from the cache or the binary
+        if(!prepared || !wabt::Succeeded(executor->CloneEnvironment(prepared))) {
+            if(!m_cache.IsEnabled()
+               || !wabt::Succeeded(m_cache.Load(m_file.GetData(), m_file.GetSize(), executor))) {
+                if(!wabt::Succeeded(executor->SetupEnvironment(m_file.GetData(), m_file.GetSize()))) {
+                    return wabt::Result::Error;
+                }
+                // A failed store only costs the next process a read of the binary
+                m_cache.Store(m_file.GetData(), m_file.GetSize(), executor);
+            }
+            // Keep an untouched copy of the first loaded module, the copy only needs the names and
+            // signatures of the host functions so the caller's preSetup is not run again
+            std::lock_guard<std::mutex> lock(m_preparedMutex);
+            if(!m_preparedExecutor) {
+                WdbExecutor::Options copyOptions;
+                copyOptions.threadOptions = options.threadOptions;
+                auto copy = new WdbExecutor(copyOptions);
+                if(wabt::Succeeded(copy->CopyHostImports(executor))
+                   && wabt::Succeeded(copy->CloneEnvironment(executor))) {
+                    m_preparedExecutor = copy;
+                } else {
+                    delete copy;
+                }
+            }
         }
         executor->SetOutputStreamHandler(options.outputStreamHandler);
         executor->SetErrorStreamHandler(options.errorStreamHandler);
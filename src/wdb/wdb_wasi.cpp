@@ -0,0 +1,253 @@
+#include <wdb/wdb_wasi.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+namespace wdb {
+    namespace {
+        const char* const kWasiModule = "wasi_snapshot_preview1";
+
+        // WASI errno values
+        const int32_t kErrnoSuccess = 0;
+        const int32_t kErrnoBadf = 8;
+        const int32_t kErrnoFault = 21;
+        const int32_t kErrnoInval = 28;
+        const int32_t kErrnoIo = 29;
+
+        // WASI clock identifiers
+        const uint32_t kClockRealtime = 0;
+        const uint32_t kClockMonotonic = 1;
+        const uint32_t kClockProcessCputime = 2;
+        const uint32_t kClockThreadCputime = 3;
+
+        // Size of an iovec: buffer pointer and length
+        const uint32_t kIovecSize = 8;
+
+        /**
+         * Get the memory of the main module
+         * @param executor
+         * @return memory index or -1
+         */
+        int GetGuestMemory(WdbExecutor *executor) {
+            wabt::interp::DefinedModule *module = executor->GetMainModule();
+            if(!module || module->memory_index == wabt::kInvalidIndex) {
+                return -1;
+            }
+            return static_cast<int>(module->memory_index);
+        }
+
+        /**
+         * Write a little endian value to guest memory
+         * @return true if in bounds
+         */
+        template <typename T>
+        bool StoreGuestValue(WdbExecutor *executor, uint32_t offset, T value) {
+            return wabt::Succeeded(executor->WriteMemory(GetGuestMemory(executor), offset, &value, sizeof(T)));
+        }
+    }
+
+    WdbWasi::WdbWasi() : m_random(std::random_device()()) {}
+
+    WdbWasi::~WdbWasi() {
+        for(auto &file : m_files) {
+            fclose(file.second);
+        }
+    }
+
+    wabt::Result WdbWasi::AddFile(uint32_t fd, std::string fileName, bool write) {
+        if(fd <= 2 || m_files.count(fd)) {
+            return wabt::Result::Error;
+        }
+        FILE *file = fopen(fileName.c_str(), write ? "wb" : "rb");
+        if(!file) {
+            return wabt::Result::Error;
+        }
+        m_files[fd] = file;
+        return wabt::Result::Ok;
+    }
+
+    wabt::Result WdbWasi::Bind(wdb::WdbExecutor *executor) {
+        wabt::Result result = wabt::Result::Ok;
+        result |= executor->BindHost<int32_t(uint32_t, uint32_t, uint32_t, uint32_t)>(kWasiModule, "fd_write",
+                [this, executor](uint32_t fd, uint32_t iovs, uint32_t iovsLength, uint32_t written) {
+                    return FdWrite(executor, fd, iovs, iovsLength, written);
+                });
+        result |= executor->BindHost<int32_t(uint32_t, uint32_t, uint32_t, uint32_t)>(kWasiModule, "fd_read",
+                [this, executor](uint32_t fd, uint32_t iovs, uint32_t iovsLength, uint32_t read) {
+                    return FdRead(executor, fd, iovs, iovsLength, read);
+                });
+        result |= executor->BindHost<int32_t(uint32_t, uint64_t, uint32_t)>(kWasiModule, "clock_time_get",
+                [this, executor](uint32_t clockId, uint64_t precision, uint32_t time) {
+                    return ClockTimeGet(executor, clockId, precision, time);
+                });
+        result |= executor->BindHost<int32_t(uint32_t, uint32_t)>(kWasiModule, "random_get",
+                [this, executor](uint32_t buffer, uint32_t length) {
+                    return RandomGet(executor, buffer, length);
+                });
+        result |= executor->BindHost<int32_t(uint32_t, uint32_t)>(kWasiModule, "args_sizes_get",
+                [this, executor](uint32_t count, uint32_t bufferSize) {
+                    return StringsSizesGet(executor, m_args, count, bufferSize);
+                });
+        result |= executor->BindHost<int32_t(uint32_t, uint32_t)>(kWasiModule, "args_get",
+                [this, executor](uint32_t pointers, uint32_t buffer) {
+                    return StringsGet(executor, m_args, pointers, buffer);
+                });
+        result |= executor->BindHost<int32_t(uint32_t, uint32_t)>(kWasiModule, "environ_sizes_get",
+                [this, executor](uint32_t count, uint32_t bufferSize) {
+                    return StringsSizesGet(executor, m_environment, count, bufferSize);
+                });
+        result |= executor->BindHost<int32_t(uint32_t, uint32_t)>(kWasiModule, "environ_get",
+                [this, executor](uint32_t pointers, uint32_t buffer) {
+                    return StringsGet(executor, m_environment, pointers, buffer);
+                });
+        // Exiting stops the interpreter with a trap
+        result |= executor->AppendHostFuncExport(kWasiModule, "proc_exit",
+                WdbHostBinding<void(uint32_t)>::GetSignature(),
+                [this](const wabt::interp::HostFunc *func, const wabt::interp::FuncSignature *sig,
+                       const wabt::interp::TypedValues &args, wabt::interp::TypedValues &results) {
+                    m_exited = true;
+                    m_exitCode = args[0].get_i32();
+                    return wabt::interp::Result::TrapHostTrapped;
+                });
+        return result;
+    }
+
+    int32_t WdbWasi::FdWrite(wdb::WdbExecutor *executor, uint32_t fd, uint32_t iovs, uint32_t iovsLength,
+                             uint32_t written) {
+        int memory = GetGuestMemory(executor);
+        auto file = m_files.find(fd);
+        if(fd != 1 && fd != 2 && file == m_files.end()) {
+            return kErrnoBadf;
+        }
+        WdbExecutor::MemoryView iovecs;
+        if(!wabt::Succeeded(executor->GetMemoryView(memory, iovs, (uint64_t) iovsLength * kIovecSize, &iovecs))) {
+            return kErrnoFault;
+        }
+        uint32_t total = 0;
+        for(uint32_t i = 0; i < iovsLength; i++) {
+            uint32_t buffer, length;
+            memcpy(&buffer, iovecs.data + i * kIovecSize, sizeof(uint32_t));
+            memcpy(&length, iovecs.data + i * kIovecSize + sizeof(uint32_t), sizeof(uint32_t));
+            // Write straight from guest memory
+            WdbExecutor::MemoryView data;
+            if(!wabt::Succeeded(executor->GetMemoryView(memory, buffer, length, &data))) {
+                return kErrnoFault;
+            }
+            const char *text = reinterpret_cast<const char*>(data.data);
+            if(fd == 1) {
+                executor->PostOutput(text, data.size);
+            } else if(fd == 2) {
+                executor->PostError(text, data.size);
+            } else if(fwrite(text, 1, data.size, file->second) != data.size) {
+                return kErrnoIo;
+            }
+            total += length;
+        }
+        return StoreGuestValue<uint32_t>(executor, written, total) ? kErrnoSuccess : kErrnoFault;
+    }
+
+    int32_t WdbWasi::FdRead(wdb::WdbExecutor *executor, uint32_t fd, uint32_t iovs, uint32_t iovsLength,
+                            uint32_t read) {
+        int memory = GetGuestMemory(executor);
+        auto file = m_files.find(fd);
+        if(fd != 0 && file == m_files.end()) {
+            return kErrnoBadf;
+        }
+        WdbExecutor::MemoryView iovecs;
+        if(!wabt::Succeeded(executor->GetMemoryView(memory, iovs, (uint64_t) iovsLength * kIovecSize, &iovecs))) {
+            return kErrnoFault;
+        }
+        // Copy the iovecs, reading may overwrite them
+        std::vector<uint8_t> iovecBytes(iovecs.data, iovecs.data + iovecs.size);
+        uint32_t total = 0;
+        for(uint32_t i = 0; i < iovsLength; i++) {
+            uint32_t buffer, length;
+            memcpy(&buffer, iovecBytes.data() + i * kIovecSize, sizeof(uint32_t));
+            memcpy(&length, iovecBytes.data() + i * kIovecSize + sizeof(uint32_t), sizeof(uint32_t));
+            // Read straight into guest memory
+            WdbExecutor::MutableMemoryView data;
+            if(!wabt::Succeeded(executor->GetMutableMemoryView(memory, buffer, length, &data))) {
+                return kErrnoFault;
+            }
+            size_t count;
+            if(fd == 0) {
+                count = std::min(data.size, m_stdin.size() - m_stdinOffset);
+                memcpy(data.data, m_stdin.data() + m_stdinOffset, count);
+                m_stdinOffset += count;
+            } else {
+                count = fread(data.data, 1, data.size, file->second);
+                if(count < data.size && ferror(file->second)) {
+                    return kErrnoIo;
+                }
+            }
+            total += static_cast<uint32_t>(count);
+            // Stop at the end of the input
+            if(count < data.size) {
+                break;
+            }
+        }
+        return StoreGuestValue<uint32_t>(executor, read, total) ? kErrnoSuccess : kErrnoFault;
+    }
+
+    int32_t WdbWasi::ClockTimeGet(wdb::WdbExecutor *executor, uint32_t clockId, uint64_t precision, uint32_t time) {
+        uint64_t nanoseconds;
+        switch (clockId) {
+            case kClockRealtime:
+                nanoseconds = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+                break;
+            case kClockMonotonic:
+                nanoseconds = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+                break;
+            case kClockProcessCputime:
+            case kClockThreadCputime:
+                nanoseconds = (uint64_t) (std::clock() * (1e9 / CLOCKS_PER_SEC));
+                break;
+            default:
+                return kErrnoInval;
+        }
+        return StoreGuestValue<uint64_t>(executor, time, nanoseconds) ? kErrnoSuccess : kErrnoFault;
+    }
+
+    int32_t WdbWasi::RandomGet(wdb::WdbExecutor *executor, uint32_t buffer, uint32_t length) {
+        WdbExecutor::MutableMemoryView data;
+        if(!wabt::Succeeded(executor->GetMutableMemoryView(GetGuestMemory(executor), buffer, length, &data))) {
+            return kErrnoFault;
+        }
+        // Fill 8 bytes per draw
+        for(size_t offset = 0; offset < data.size; offset += sizeof(uint64_t)) {
+            uint64_t value = m_random();
+            memcpy(data.data + offset, &value, std::min(sizeof(uint64_t), data.size - offset));
+        }
+        return kErrnoSuccess;
+    }
+
+    int32_t WdbWasi::StringsSizesGet(wdb::WdbExecutor *executor, const std::vector<std::string> &strings,
+                                     uint32_t count, uint32_t bufferSize) {
+        uint32_t size = 0;
+        for(auto &string : strings) {
+            size += static_cast<uint32_t>(string.size() + 1);
+        }
+        if(!StoreGuestValue<uint32_t>(executor, count, static_cast<uint32_t>(strings.size()))
+           || !StoreGuestValue<uint32_t>(executor, bufferSize, size)) {
+            return kErrnoFault;
+        }
+        return kErrnoSuccess;
+    }
+
+    int32_t WdbWasi::StringsGet(wdb::WdbExecutor *executor, const std::vector<std::string> &strings,
+                                uint32_t pointers, uint32_t buffer) {
+        int memory = GetGuestMemory(executor);
+        for(size_t i = 0; i < strings.size(); i++) {
+            // Null terminated string and its pointer
+            if(!StoreGuestValue<uint32_t>(executor, pointers + i * sizeof(uint32_t), buffer)
+               || !wabt::Succeeded(executor->WriteMemory(memory, buffer, strings[i].c_str(), strings[i].size() + 1))) {
+                return kErrnoFault;
+            }
+            buffer += static_cast<uint32_t>(strings[i].size() + 1);
+        }
+        return kErrnoSuccess;
+    }
+}